@@ -0,0 +1,172 @@
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <tlx/cmdline_parser.hpp>
+
+#include "io.hpp"
+#include "timer.hpp"
+#include "lce_naive_ultra.hpp"
+#include "lce_semi_synchronizing_sets_par_append.hpp"
+
+/* Appends a text in chunks to LceSemiSyncSetsParAppend and answers random LCE
+ * queries on the text appended so far after each chunk. Every k-th query is
+ * checked against the naive LCE of the same prefix of an untouched copy of
+ * the text. */
+class append_benchmark {
+
+public:
+  void run() {
+    if (algorithm == "s2048_par") {
+      run_append<2048>();
+    } else if (algorithm == "s1024_par") {
+      run_append<1024>();
+    } else if (algorithm == "s512_par" || algorithm == "s_par") {
+      run_append<512>();
+    } else if (algorithm == "s256_par") {
+      run_append<256>();
+    } else {
+      std::cerr << "Unknown algorithm " << algorithm << std::endl;
+    }
+  }
+
+private:
+  template <uint64_t kTau>
+  void run_append() {
+    std::vector<uint8_t> const text = load_text(file_path, prefix_length);
+    if (text.empty() || chunk_size == 0) {
+      std::cerr << "Empty text or chunk" << std::endl;
+      return;
+    }
+    LceUltraNaive const lce_naive(text);
+
+    timer t;
+    lce_test::par::LceSemiSyncSetsParAppend<kTau> lce_ds({}, lce_test::par::sss_ranking::string_sort,
+                                                         min_index_size);
+    size_t const construction_time = t.get_and_reset();
+
+    std::mt19937_64 gen(seed);
+    uint64_t appends = 0;
+    size_t append_time = 0;
+    size_t max_append_time = 0;
+    size_t query_time = 0;
+    uint64_t queries = 0;
+    uint64_t lce_sum = 0;
+    uint64_t checked_queries = 0;
+    uint64_t wrong_queries = 0;
+
+    // Answers the queries on the text appended so far. Only the queries are
+    // timed, the check is done afterwards.
+    std::vector<std::pair<uint64_t, uint64_t>> positions(queries_per_append);
+    std::vector<uint64_t> results(queries_per_append);
+    auto const query = [&]() {
+      uint64_t const size = lce_ds.size();
+      std::uniform_int_distribution<uint64_t> dist(0, size - 1);
+      for (auto& [i, j] : positions) {
+        i = dist(gen);
+        j = dist(gen);
+      }
+      t.reset();
+      for (uint64_t q = 0; q < queries_per_append; ++q) {
+        results[q] = lce_ds.lce(positions[q].first, positions[q].second);
+      }
+      query_time += t.get();
+      for (uint64_t q = 0; q < queries_per_append; ++q) {
+        lce_sum += results[q];
+        if (check_every > 0 && (queries + q) % check_every == 0) {
+          auto const [i, j] = positions[q];
+          ++checked_queries;
+          wrong_queries += (results[q] != lce_naive.lce_bounded(i, j, size - std::max(i, j)));
+        }
+      }
+      queries += queries_per_append;
+    };
+
+    for (uint64_t begin = 0; begin < text.size(); begin += chunk_size) {
+      std::span<uint8_t const> const chunk(text.data() + begin,
+                                           std::min<uint64_t>(chunk_size, text.size() - begin));
+      t.reset();
+      lce_ds.append(chunk);
+      size_t const time = t.get();
+      append_time += time;
+      max_append_time = std::max(max_append_time, time);
+      ++appends;
+      query();
+    }
+
+    // Index the rest of the buffer and query the final parts
+    t.reset();
+    lce_ds.rebuild();
+    size_t const rebuild_time = t.get();
+    query();
+
+    std::cout << "RESULT "
+              << "algo=" << algorithm << "_append "
+              << "input=" << file_path << " "
+              << "size=" << text.size() << " "
+              << "chunk_size=" << chunk_size << " "
+              << "min_index_size=" << min_index_size << " "
+              << "appends=" << appends << " "
+              << "construction_time=" << construction_time << " "
+              << "append_time=" << append_time << " "
+              << "max_append_time=" << max_append_time << " "
+              << "rebuild_time=" << rebuild_time << " "
+              << "parts=" << lce_ds.num_parts() << " "
+              << "lce_size=" << lce_ds.getSizeInBytes() << " "
+              << "queries=" << queries << " "
+              << "query_time=" << query_time << " "
+              << "lce_sum=" << lce_sum << " "
+              << "checked=" << checked_queries << " "
+              << "check=" << (wrong_queries == 0 ? "passed" :
+                              "failed(" + std::to_string(wrong_queries) + ")")
+              << std::endl;
+  }
+
+public:
+  std::string file_path;
+  uint64_t prefix_length = 0;
+  std::string algorithm = "s1024_par";
+  uint64_t chunk_size = uint64_t{1} << 20;
+  uint64_t min_index_size = uint64_t{1} << 24;
+  uint64_t queries_per_append = 10000;
+  uint64_t check_every = 1;
+  uint64_t seed = 42;
+}; // class append_benchmark
+
+int32_t main(int argc, char *argv[]) {
+  append_benchmark bench;
+
+  tlx::CmdlineParser cp;
+  cp.set_description("Appends a text in chunks to the append-only parallel "
+                     "string synchronizing set and answers random LCE queries "
+                     "on the text appended so far after each chunk.");
+  cp.set_author("Alexander Herlez <alexander.herlez@tu-dortmund.de>");
+
+  cp.add_param_string("file", bench.file_path, "The text which is appended");
+  cp.add_bytes('p', "pre", bench.prefix_length, "Size of the prefix in bytes "
+               "that will be read (optional).");
+  cp.add_string('a', "algorithm", bench.algorithm, "Parallel string "
+                "synchronizing sets [s256_par], [s512_par], [s1024_par] "
+                "(default), [s2048_par].");
+  cp.add_bytes('b', "chunk", bench.chunk_size, "Bytes per append "
+               "(default=1MiB).");
+  cp.add_bytes('m', "min_index", bench.min_index_size, "Buffered bytes that "
+               "start a merge (default=16MiB).");
+  cp.add_bytes('q', "queries", bench.queries_per_append, "Number of LCE "
+               "queries after each append (default=10,000).");
+  cp.add_bytes('c', "check_every", bench.check_every, "Compare every k-th "
+               "query with the naive LCE, 0 disables the check (default=1).");
+  cp.add_bytes('s', "seed", bench.seed, "Seed of the random queries.");
+
+  if (!cp.process(argc, argv)) {
+    std::exit(EXIT_FAILURE);
+  }
+
+  bench.run();
+  return 0;
+}
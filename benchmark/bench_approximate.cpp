@@ -0,0 +1,253 @@
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <tlx/cmdline_parser.hpp>
+
+#include "io.hpp"
+#include "timer.hpp"
+#include "lce_approximate.hpp"
+#include "lce_naive.hpp"
+#include "lce_prezza.hpp"
+#include "lce_semi_synchronizing_sets_par.hpp"
+
+/* Times k-mismatch LCE queries (kangaroo jumps) once one query after the
+ * other and once advancing all queries in lockstep (lce_k_mismatch_batch),
+ * and compares both with a naive scan. Then computes banded edit distances
+ * of short substrings, which are checked against the dynamic programming
+ * matrix. */
+class approximate_benchmark {
+
+public:
+  void run() {
+    if (algorithm == "n") {
+      run_backend([](std::vector<uint8_t>& text) {
+        return std::make_unique<LceNaive>(text);
+      });
+    } else if (algorithm == "p") {
+      run_backend([](std::vector<uint8_t>& text) {
+        return std::make_unique<LcePrezza<128>>(reinterpret_cast<uint64_t*>(text.data()),
+                                                text.size());
+      }, true);
+    } else if (algorithm == "s2048_par") {
+      run_sss_par<2048>();
+    } else if (algorithm == "s1024_par") {
+      run_sss_par<1024>();
+    } else if (algorithm == "s512_par" || algorithm == "s_par") {
+      run_sss_par<512>();
+    } else if (algorithm == "s256_par") {
+      run_sss_par<256>();
+    } else {
+      std::cerr << "Unknown algorithm " << algorithm << std::endl;
+    }
+  }
+
+private:
+  template <uint64_t kTau>
+  void run_sss_par() {
+    run_backend([](std::vector<uint8_t>& text) {
+      return std::make_unique<lce_test::par::LceSemiSyncSetsPar<kTau>>(text, false);
+    });
+  }
+
+  template <typename builder_type>
+  void run_backend(builder_type&& build, bool const pad_text_to_words = false) {
+    std::vector<uint8_t> text = load_text(file_path, prefix_length);
+    std::vector<uint8_t> const check_text = text;
+    uint64_t const text_size = text.size();
+    if (text_size == 0) {
+      std::cerr << "Empty text" << std::endl;
+      return;
+    }
+    if (pad_text_to_words) {
+      text.resize(text.size() + (8 - (text.size() % 8)));
+    }
+
+    timer t;
+    auto const lce_ds = build(text);
+    size_t const construction_time = t.get_and_reset();
+
+    std::mt19937_64 gen(seed);
+    std::uniform_int_distribution<uint64_t> dist(0, text_size - 1);
+
+    // k-mismatch queries
+    std::vector<uint64_t> indices(2 * number_queries);
+    for (auto& index : indices) {
+      index = dist(gen);
+    }
+    std::vector<uint64_t> results(number_queries);
+    t.reset();
+    for (size_t q = 0; q < number_queries; ++q) {
+      results[q] = lce_test::lce_k_mismatch(*lce_ds, text_size, indices[2 * q],
+                                            indices[2 * q + 1], mismatches);
+    }
+    size_t const unbatched_time = t.get_and_reset();
+    std::vector<uint64_t> batch_results(number_queries);
+    lce_test::lce_k_mismatch_batch(*lce_ds, text_size, indices, mismatches, batch_results);
+    size_t const batched_time = t.get_and_reset();
+
+    uint64_t length_sum = 0;
+    uint64_t checked_queries = 0;
+    uint64_t wrong_queries = 0;
+    for (size_t q = 0; q < number_queries; ++q) {
+      length_sum += results[q];
+      wrong_queries += (results[q] != batch_results[q]);
+      if (check_every > 0 && q % check_every == 0) {
+        ++checked_queries;
+        wrong_queries += (results[q] != naive_k_mismatch(check_text, indices[2 * q],
+                                                         indices[2 * q + 1]));
+      }
+    }
+
+    std::cout << "RESULT "
+              << "algo=" << algorithm << "_k_mismatch "
+              << "input=" << file_path << " "
+              << "size=" << text_size << " "
+              << "k=" << mismatches << " "
+              << "queries=" << number_queries << " "
+              << "construction_time=" << construction_time << " "
+              << "unbatched_time=" << unbatched_time << " "
+              << "batched_time=" << batched_time << " "
+              << "length_sum=" << length_sum << " "
+              << "checked=" << checked_queries << " "
+              << "check=" << (wrong_queries == 0 ? "passed" :
+                              "failed(" + std::to_string(wrong_queries) + ")")
+              << std::endl;
+
+    // Edit distances of substrings of length substring_length (or less at
+    // the end of the text). Half of the second substrings start close to the
+    // first one, so their distance is often within the band.
+    uint64_t const length = std::min(substring_length, text_size);
+    std::uniform_int_distribution<uint64_t> start_dist(0, text_size - length);
+    std::uniform_int_distribution<uint64_t> shift_dist(0, 2 * max_edits);
+    std::vector<uint64_t> pairs(2 * number_edit_queries);
+    for (size_t q = 0; q < number_edit_queries; ++q) {
+      pairs[2 * q] = start_dist(gen);
+      pairs[2 * q + 1] = (q % 2 == 0)
+          ? start_dist(gen)
+          : std::min(pairs[2 * q] + shift_dist(gen), text_size - length);
+    }
+    std::vector<uint64_t> distances(number_edit_queries);
+    t.reset();
+    for (size_t q = 0; q < number_edit_queries; ++q) {
+      distances[q] = lce_test::edit_distance_banded(*lce_ds, pairs[2 * q], length,
+                                                    pairs[2 * q + 1], length, max_edits);
+    }
+    size_t const edit_time = t.get_and_reset();
+
+    uint64_t within_band = 0;
+    uint64_t wrong_distances = 0;
+    for (size_t q = 0; q < number_edit_queries; ++q) {
+      within_band += (distances[q] <= max_edits);
+      uint64_t const expected =
+          std::min(naive_edit_distance(check_text, pairs[2 * q], pairs[2 * q + 1], length),
+                   max_edits + 1);
+      wrong_distances += (distances[q] != expected);
+    }
+
+    std::cout << "RESULT "
+              << "algo=" << algorithm << "_edit_distance "
+              << "input=" << file_path << " "
+              << "size=" << text_size << " "
+              << "length=" << length << " "
+              << "max_edits=" << max_edits << " "
+              << "queries=" << number_edit_queries << " "
+              << "edit_time=" << edit_time << " "
+              << "within_band=" << within_band << " "
+              << "check=" << (wrong_distances == 0 ? "passed" :
+                              "failed(" + std::to_string(wrong_distances) + ")")
+              << std::endl;
+  }
+
+  uint64_t naive_k_mismatch(std::vector<uint8_t> const& text, uint64_t const i,
+                            uint64_t const j) const {
+    uint64_t const max_length = text.size() - std::max(i, j);
+    if (i == j) {
+      return max_length;
+    }
+    uint64_t length = 0;
+    uint64_t found = 0;
+    for (; length < max_length; ++length) {
+      if (text[i + length] != text[j + length] && found++ == mismatches) {
+        break;
+      }
+    }
+    return length;
+  }
+
+  /* Edit distance of T[a, a + length) and T[b, b + length) by the dynamic
+     programming matrix (one row at a time) */
+  static uint64_t naive_edit_distance(std::vector<uint8_t> const& text,
+                                      uint64_t const a, uint64_t const b,
+                                      uint64_t const length) {
+    std::vector<uint64_t> row(length + 1);
+    std::vector<uint64_t> next(length + 1);
+    for (uint64_t y = 0; y <= length; ++y) {
+      row[y] = y;
+    }
+    for (uint64_t x = 1; x <= length; ++x) {
+      next[0] = x;
+      for (uint64_t y = 1; y <= length; ++y) {
+        next[y] = std::min({row[y] + 1, next[y - 1] + 1,
+                            row[y - 1] + (text[a + x - 1] != text[b + y - 1])});
+      }
+      std::swap(row, next);
+    }
+    return row[length];
+  }
+
+public:
+  std::string file_path;
+  uint64_t prefix_length = 0;
+  std::string algorithm = "p";
+  uint64_t number_queries = 1000000;
+  uint64_t mismatches = 8;
+  uint64_t check_every = 1;
+  uint64_t number_edit_queries = 10000;
+  uint64_t substring_length = 100;
+  uint64_t max_edits = 16;
+  uint64_t seed = 42;
+}; // class approximate_benchmark
+
+int32_t main(int argc, char *argv[]) {
+  approximate_benchmark bench;
+
+  tlx::CmdlineParser cp;
+  cp.set_description("Times k-mismatch LCE queries with and without "
+                     "batching, and checks banded edit distances of short "
+                     "substrings against dynamic programming.");
+  cp.set_author("Alexander Herlez <alexander.herlez@tu-dortmund.de>");
+
+  cp.add_param_string("file", bench.file_path, "The text which is queried");
+  cp.add_bytes('p', "pre", bench.prefix_length, "Size of the prefix in bytes "
+               "that will be read (optional).");
+  cp.add_string('a', "algorithm", bench.algorithm, "LCE data structure: "
+                "[n]aive, [p]rezza (default), or parallel string "
+                "synchronizing sets [s256_par], [s512_par], [s1024_par], "
+                "[s2048_par].");
+  cp.add_bytes('q', "queries", bench.number_queries, "Number of k-mismatch "
+               "queries (default=1,000,000).");
+  cp.add_bytes('k', "mismatches", bench.mismatches, "Number of mismatches "
+               "k (default=8).");
+  cp.add_bytes('c', "check_every", bench.check_every, "Compare every k-th "
+               "k-mismatch query with a naive scan, 0 disables the check "
+               "(default=1).");
+  cp.add_bytes('e', "edit_queries", bench.number_edit_queries, "Number of "
+               "edit distance queries, which are all checked (default=10,000).");
+  cp.add_bytes('l', "length", bench.substring_length, "Length of the "
+               "substrings of the edit distance queries (default=100).");
+  cp.add_bytes('m', "max_edits", bench.max_edits, "Band of the edit "
+               "distance (default=16).");
+  cp.add_bytes('s', "seed", bench.seed, "Seed of the random queries.");
+
+  if (!cp.process(argc, argv)) {
+    std::exit(EXIT_FAILURE);
+  }
+
+  bench.run();
+  return 0;
+}
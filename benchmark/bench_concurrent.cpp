@@ -0,0 +1,200 @@
+#include <omp.h>
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <tlx/cmdline_parser.hpp>
+
+#include "io.hpp"
+#include "timer.hpp"
+#include "lce_naive.hpp"
+#include "lce_naive_ultra.hpp"
+#include "lce_prezza.hpp"
+#include "lce_prezza_mersenne.hpp"
+#include "lce_semi_synchronizing_sets_par.hpp"
+#include "util/huge_pages.hpp"
+#include "util/lce_frozen.hpp"
+
+/* Stress test for concurrent queries: one data structure is built and frozen,
+ * then all threads query the same instance through copies of the frozen
+ * handle. Each thread checks a sample of its results against the naive LCE of
+ * an untouched copy of the text. */
+class concurrent_benchmark {
+
+public:
+  void run() {
+    if (algorithm == "n") {
+      run_backend([](std::vector<uint8_t>& text) {
+        return std::make_unique<LceNaive>(text);
+      });
+    } else if (algorithm == "m") {
+      run_backend([](std::vector<uint8_t>& text) {
+        return std::make_unique<rklce::LcePrezzaMersenne>(text);
+      });
+    } else if (algorithm == "p") {
+      run_backend([](std::vector<uint8_t>& text) {
+        return std::make_unique<LcePrezza<128>>(reinterpret_cast<uint64_t*>(text.data()),
+                                                text.size());
+      }, true);
+    } else if (algorithm == "s2048_par") {
+      run_sss_par<2048>();
+    } else if (algorithm == "s1024_par") {
+      run_sss_par<1024>();
+    } else if (algorithm == "s512_par" || algorithm == "s_par") {
+      run_sss_par<512>();
+    } else if (algorithm == "s256_par") {
+      run_sss_par<256>();
+    } else {
+      std::cerr << "Unknown algorithm " << algorithm << std::endl;
+    }
+  }
+
+private:
+  template <uint64_t kTau>
+  void run_sss_par() {
+    run_backend([this](std::vector<uint8_t>& text) {
+      auto lce_sss = std::make_unique<lce_test::par::LceSemiSyncSetsPar<kTau>>(text, false);
+      if (numa_replicas) {
+        lce_sss->replicate_numa();
+      }
+      return lce_sss;
+    });
+  }
+
+  template <typename builder_type>
+  void run_backend(builder_type&& build, bool const pad_text_to_words = false) {
+    std::vector<uint8_t> text = load_text(file_path, prefix_length);
+    std::vector<uint8_t> const check_text = text;
+    uint64_t const text_size = text.size();
+    if (pad_text_to_words) {
+      text.resize(text.size() + (8 - (text.size() % 8)));
+    }
+    if (text_size == 0) {
+      std::cerr << "Empty text" << std::endl;
+      return;
+    }
+
+    timer t;
+    auto const lce_ds = lce_test::freeze(build(text));
+    size_t const construction_time = t.get_and_reset();
+
+    LceUltraNaive const lce_naive(check_text);
+    int const max_threads = omp_get_max_threads();
+
+    std::vector<int> thread_counts;
+    for (int threads = 1; threads < max_threads; threads *= 2) {
+      thread_counts.push_back(threads);
+    }
+    thread_counts.push_back(max_threads);
+
+    for (int const threads : thread_counts) {
+      std::atomic<uint64_t> checked_queries = 0;
+      std::atomic<uint64_t> wrong_queries = 0;
+      std::atomic<uint64_t> lce_sum = 0;
+      t.reset();
+
+#pragma omp parallel num_threads(threads)
+      {
+        // Each thread holds its own handle, i.e., only the reference count
+        // is shared besides the (read-only) data structure itself.
+        auto const local_ds = lce_ds;
+        std::mt19937_64 gen(seed + omp_get_thread_num());
+        std::uniform_int_distribution<uint64_t> dist(0, text_size - 1);
+        uint64_t local_sum = 0;
+        uint64_t local_checked = 0;
+        uint64_t local_wrong = 0;
+
+#pragma omp for schedule(static)
+        for (uint64_t q = 0; q < number_queries; ++q) {
+          uint64_t const i = dist(gen);
+          uint64_t const j = dist(gen);
+          uint64_t const lce = local_ds.lce(i, j);
+          local_sum += lce;
+          if (check_every > 0 && q % check_every == 0) {
+            ++local_checked;
+            local_wrong += (lce != lce_naive.lce(i, j));
+          }
+        }
+        lce_sum += local_sum;
+        checked_queries += local_checked;
+        wrong_queries += local_wrong;
+      }
+      size_t const query_time = t.get_and_reset();
+
+      std::cout << "RESULT "
+                << "algo=" << algorithm << "_concurrent "
+                << "input=" << file_path << " "
+                << "size=" << text_size << " "
+                << "threads=" << threads << " "
+                << "queries=" << number_queries << " "
+                << "construction_time=" << construction_time << " "
+                << "lce_size=" << lce_ds.getSizeInBytes() << " "
+                << "query_time=" << query_time << " "
+                << "queries_per_sec="
+                << (query_time > 0 ? number_queries * 1000 / query_time : 0) << " "
+                << "lce_sum=" << lce_sum << " "
+                << "checked=" << checked_queries << " "
+                << "check=" << (wrong_queries == 0 ? "passed" :
+                                "failed(" + std::to_string(wrong_queries) + ")")
+                << std::endl;
+    }
+  }
+
+public:
+  std::string file_path;
+  uint64_t prefix_length = 0;
+  std::string algorithm = "p";
+  uint64_t number_queries = 10000000;
+  uint64_t check_every = 1000;
+  uint64_t seed = 42;
+  bool numa_replicas = false;
+  std::string huge_pages = "off";
+}; // class concurrent_benchmark
+
+int32_t main(int argc, char *argv[]) {
+  concurrent_benchmark bench;
+
+  tlx::CmdlineParser cp;
+  cp.set_description("Builds one LCE data structure and answers random LCE "
+                     "queries from 1, 2, 4, ... threads concurrently, all "
+                     "using the same instance.");
+  cp.set_author("Alexander Herlez <alexander.herlez@tu-dortmund.de>");
+
+  cp.add_param_string("file", bench.file_path, "The text which is queried");
+  cp.add_bytes('p', "pre", bench.prefix_length, "Size of the prefix in bytes "
+               "that will be read (optional).");
+  cp.add_string('a', "algorithm", bench.algorithm, "LCE data structure: "
+                "[n]aive, prezza [m]ersenne, [p]rezza (default), or parallel "
+                "string synchronizing sets [s256_par], [s512_par], "
+                "[s1024_par], [s2048_par].");
+  cp.add_bytes('q', "queries", bench.number_queries, "Number of LCE queries "
+               "per thread count (default=10,000,000).");
+  cp.add_bytes('c', "check_every", bench.check_every, "Compare every k-th "
+               "query with the naive LCE, 0 disables the check "
+               "(default=1000).");
+  cp.add_bytes('s', "seed", bench.seed, "Seed of the random queries.");
+  cp.add_string("huge_pages", bench.huge_pages, "Back the text and the large "
+                "arrays of parallel sss with huge pages: off (default), thp, "
+                "2m or 1g.");
+  cp.add_flag("numa", bench.numa_replicas, "Replicate the query arrays of "
+              "parallel sss on each NUMA node.");
+
+  if (!cp.process(argc, argv)) {
+    std::exit(EXIT_FAILURE);
+  }
+
+  lce_test::huge_page_mode huge_pages;
+  if (!lce_test::parse_huge_page_mode(bench.huge_pages, huge_pages)) {
+    std::cerr << "Unknown huge page mode " << bench.huge_pages << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+  lce_test::set_huge_page_mode(huge_pages);
+
+  bench.run();
+  return 0;
+}
@@ -0,0 +1,194 @@
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <tlx/cmdline_parser.hpp>
+
+#include "io.hpp"
+#include "timer.hpp"
+#include "lce_lz77.hpp"
+#include "lce_prezza.hpp"
+#include "lce_semi_synchronizing_sets_par.hpp"
+#include "util/huge_pages.hpp"
+#include "util_ssss_par/ssss_par.hpp"
+
+/* Computes an approximate LZ77 factorization with the LCE data structure and
+ * the string synchronizing set as sample, optionally writes the phrases to a
+ * file (two 64-bit integers per phrase), checks them by decoding and compares
+ * their number with the greedy factorization. */
+class lz77_benchmark {
+
+public:
+  void run() {
+    if (algorithm == "p256") {
+      run_prezza<256>();
+    } else if (algorithm == "p512" || algorithm == "p") {
+      run_prezza<512>();
+    } else if (algorithm == "p1024") {
+      run_prezza<1024>();
+    } else if (algorithm == "s2048_par") {
+      run_sss_par<2048>();
+    } else if (algorithm == "s1024_par") {
+      run_sss_par<1024>();
+    } else if (algorithm == "s512_par" || algorithm == "s_par") {
+      run_sss_par<512>();
+    } else if (algorithm == "s256_par") {
+      run_sss_par<256>();
+    } else {
+      std::cerr << "Unknown algorithm " << algorithm << std::endl;
+    }
+  }
+
+private:
+  /* In-place fingerprints: the sample is computed before the text is
+     overwritten. */
+  template <uint64_t kTau>
+  void run_prezza() {
+    std::vector<uint8_t> text = load_text(file_path, prefix_length);
+    uint64_t const text_size = text.size();
+    std::vector<uint8_t> const check_text = check ? text : std::vector<uint8_t>();
+    uint64_t const greedy_phrases = greedy ? lce_test::lz77_greedy_num_phrases(text) : 0;
+
+    timer t;
+    std::vector<uint64_t> sample;
+    {
+      string_synchronizing_set_par<kTau, uint64_t> const sync_set(text);
+      sample.assign(sync_set.get_sss().begin(), sync_set.get_sss().end());
+    }
+    text.resize(text.size() + (8 - (text.size() % 8)));
+    LcePrezza<128> const lce_ds(reinterpret_cast<uint64_t*>(text.data()), text.size());
+    factorize(lce_ds, text_size, std::move(sample), check_text, greedy_phrases, t);
+  }
+
+  template <uint64_t kTau>
+  void run_sss_par() {
+    std::vector<uint8_t> const text = load_text(file_path, prefix_length);
+    uint64_t const greedy_phrases = greedy ? lce_test::lz77_greedy_num_phrases(text) : 0;
+
+    timer t;
+    lce_test::par::LceSemiSyncSetsPar<kTau> const lce_ds(text, false);
+    factorize(lce_ds, text.size(), lce_ds.getSyncSet(), text, greedy_phrases, t);
+  }
+
+  template <typename backend_type>
+  void factorize(backend_type const& lce_ds, uint64_t const text_size,
+                 std::vector<uint64_t> sample,
+                 std::vector<uint8_t> const& check_text,
+                 uint64_t const greedy_phrases, timer& t) {
+    size_t const lce_time = t.get_and_reset();
+    lce_test::LceApproximateLz77Factorizer const factorizer(lce_ds, text_size, std::move(sample));
+    size_t const sort_time = t.get_and_reset();
+
+    std::ofstream out;
+    if (!output_path.empty()) {
+      out.open(output_path, std::ios::out | std::ios::binary | std::ios::trunc);
+    }
+    std::vector<uint8_t> decoded;
+    uint64_t num_literals = 0;
+    bool decodable = true;
+
+    t.reset();
+    uint64_t const num_phrases = factorizer.factorize(
+        [&](std::span<lce_test::lz77_phrase const> const phrases) {
+      if (out.is_open()) {
+        out.write(reinterpret_cast<char const*>(phrases.data()),
+                  phrases.size_bytes());
+      }
+      for (auto const& phrase : phrases) {
+        num_literals += (phrase.length == 0);
+        if (!check) {
+          continue;
+        }
+        if (phrase.length == 0) {
+          decoded.push_back(phrase.source);
+        } else if (phrase.source < decoded.size()) {
+          for (uint64_t k = 0; k < phrase.length; ++k) {
+            decoded.push_back(decoded[phrase.source + k]);
+          }
+        } else {
+          decodable = false;
+        }
+      }
+    }, block_size);
+    size_t const factorize_time = t.get_and_reset();
+
+    std::cout << "RESULT "
+              << "algo=" << algorithm << "_lz77 "
+              << "input=" << file_path << " "
+              << "size=" << text_size << " "
+              << "lce_construct_time=" << lce_time << " "
+              << "sample_sort_time=" << sort_time << " "
+              << "factorize_time=" << factorize_time << " "
+              << "sample_size=" << factorizer.sample_size() << " "
+              << "lce_size=" << lce_ds.getSizeInBytes() << " "
+              << "factorizer_size=" << factorizer.memory_breakdown().total() << " "
+              << "phrases=" << num_phrases << " "
+              << "literals=" << num_literals;
+    if (greedy) {
+      std::cout << " greedy_phrases=" << greedy_phrases
+                << " phrase_ratio=" << static_cast<double>(num_phrases) / greedy_phrases;
+    }
+    if (check) {
+      std::cout << " check=" << ((decodable && decoded == check_text) ? "passed" : "failed");
+    }
+    std::cout << std::endl;
+  }
+
+public:
+  std::string file_path;
+  std::string output_path;
+  uint64_t prefix_length = 0;
+  std::string algorithm = "s_par";
+  uint64_t block_size = uint64_t{1} << 22;
+  bool check = false;
+  bool greedy = false;
+  std::string huge_pages = "off";
+}; // class lz77_benchmark
+
+int32_t main(int argc, char *argv[]) {
+  lz77_benchmark bench;
+
+  tlx::CmdlineParser cp;
+  cp.set_description("Computes an approximate LZ77 factorization using LCE queries and "
+                     "the sorted string synchronizing set.");
+  cp.set_author("Alexander Herlez <alexander.herlez@tu-dortmund.de>");
+
+  cp.add_param_string("file", bench.file_path, "The text which is factorized");
+  cp.add_string('o', "output", bench.output_path, "File the phrases are "
+                "written to, two 64-bit integers (source, length) each, "
+                "where length 0 is a literal (optional).");
+  cp.add_bytes('p', "pre", bench.prefix_length, "Size of the prefix in bytes "
+               "that will be read (optional).");
+  cp.add_string('a', "algorithm", bench.algorithm, "LCE data structure: "
+                "in-place prezza with a sample of tau [p256], [p512], "
+                "[p1024], or parallel string synchronizing sets [s256_par], "
+                "[s512_par] (default), [s1024_par], [s2048_par].");
+  cp.add_bytes('b', "block_size", bench.block_size, "Bytes that are "
+               "factorized by one thread at once (default=4Mi).");
+  cp.add_flag('c', "check", bench.check, "Decode the phrases and compare "
+              "them with the text.");
+  cp.add_flag('g', "greedy", bench.greedy, "Also compute the number of "
+              "phrases of the greedy factorization with a full suffix array "
+              "(12 bytes per character) and report the ratio.");
+  cp.add_string("huge_pages", bench.huge_pages, "Back the text and the large "
+                "arrays of parallel sss with huge pages: off (default), thp, "
+                "2m or 1g.");
+
+  if (!cp.process(argc, argv)) {
+    std::exit(EXIT_FAILURE);
+  }
+
+  lce_test::huge_page_mode huge_pages;
+  if (!lce_test::parse_huge_page_mode(bench.huge_pages, huge_pages)) {
+    std::cerr << "Unknown huge page mode " << bench.huge_pages << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+  lce_test::set_huge_page_mode(huge_pages);
+
+  bench.run();
+  return 0;
+}
@@ -0,0 +1,192 @@
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <tlx/cmdline_parser.hpp>
+
+#include "io.hpp"
+#include "timer.hpp"
+#include "lce_matching_statistics.hpp"
+#include "lce_naive.hpp"
+#include "lce_prezza.hpp"
+#include "lce_semi_synchronizing_sets_par.hpp"
+#include "util/huge_pages.hpp"
+
+/* Computes the matching statistics of a query file with respect to a text,
+ * streaming the query in blocks. Every k-th result is checked against all
+ * text positions. */
+class matching_statistics_benchmark {
+
+public:
+  void run() {
+    if (algorithm == "n") {
+      run_backend([](std::vector<uint8_t>& text) {
+        return std::make_unique<LceNaive>(text);
+      });
+    } else if (algorithm == "p") {
+      run_backend([](std::vector<uint8_t>& text) {
+        return std::make_unique<LcePrezza<128>>(reinterpret_cast<uint64_t*>(text.data()),
+                                                text.size());
+      }, true);
+    } else if (algorithm == "s2048_par") {
+      run_sss_par<2048>();
+    } else if (algorithm == "s1024_par") {
+      run_sss_par<1024>();
+    } else if (algorithm == "s512_par" || algorithm == "s_par") {
+      run_sss_par<512>();
+    } else if (algorithm == "s256_par") {
+      run_sss_par<256>();
+    } else {
+      std::cerr << "Unknown algorithm " << algorithm << std::endl;
+    }
+  }
+
+private:
+  template <uint64_t kTau>
+  void run_sss_par() {
+    run_backend([](std::vector<uint8_t>& text) {
+      return std::make_unique<lce_test::par::LceSemiSyncSetsPar<kTau>>(text, false);
+    });
+  }
+
+  template <typename builder_type>
+  void run_backend(builder_type&& build, bool const pad_text_to_words = false) {
+    std::vector<uint8_t> text = load_text(file_path, prefix_length);
+    std::vector<uint8_t> check_text;
+    if (check_every > 0) {
+      check_text = text;
+    }
+    uint64_t const text_size = text.size();
+
+    timer t;
+    lce_test::LceMatchingStatistics const ms(std::move(text), build,
+                                             pad_text_to_words);
+    size_t const construction_time = t.get_and_reset();
+
+    std::ifstream query(query_path, std::ios::in | std::ios::binary);
+    if (!query) {
+      std::cerr << "File " << query_path << " not found" << std::endl;
+      return;
+    }
+
+    uint64_t length_sum = 0;
+    uint64_t max_length = 0;
+    uint64_t checked = 0;
+    uint64_t wrong = 0;
+    std::ifstream check_query(query_path, std::ios::in | std::ios::binary);
+    std::vector<uint8_t> pattern;
+
+    t.reset();
+    uint64_t const query_size = ms.stream(query,
+        [&](uint64_t const first_pos, std::span<uint64_t const> const lengths,
+            std::span<uint64_t const> const positions) {
+      for (uint64_t k = 0; k < lengths.size(); ++k) {
+        length_sum += lengths[k];
+        max_length = std::max(max_length, lengths[k]);
+        if (check_every > 0 && (first_pos + k) % check_every == 0) {
+          ++checked;
+          wrong += !check(check_text, check_query, first_pos + k, lengths[k],
+                          positions[k], pattern);
+        }
+      }
+    }, block_size, chunk_size);
+    size_t const query_time = t.get_and_reset();
+
+    std::cout << "RESULT "
+              << "algo=" << algorithm << "_ms "
+              << "input=" << file_path << " "
+              << "query=" << query_path << " "
+              << "size=" << text_size << " "
+              << "query_size=" << query_size << " "
+              << "construction_time=" << construction_time << " "
+              << "lce_size=" << ms.getSizeInBytes() << " "
+              << "query_time=" << query_time << " "
+              << "ms_sum=" << length_sum << " "
+              << "ms_max=" << max_length << " "
+              << "checked=" << checked << " "
+              << "check=" << (wrong == 0 ? "passed" :
+                              "failed(" + std::to_string(wrong) + ")")
+              << std::endl;
+  }
+
+  /* The match must occur at the reported position and no text position may
+     match one more character. */
+  static bool check(std::vector<uint8_t> const& text, std::ifstream& query,
+                    uint64_t const k, uint64_t const length,
+                    uint64_t const text_pos, std::vector<uint8_t>& pattern) {
+    pattern.resize(length + 1);
+    query.clear();
+    query.seekg(k);
+    query.read(reinterpret_cast<char*>(pattern.data()), length + 1);
+    pattern.resize(query.gcount());
+    if (pattern.size() < length || text_pos + length > text.size() ||
+        !std::equal(pattern.begin(), pattern.begin() + length,
+                    text.begin() + text_pos)) {
+      return false;
+    }
+    if (pattern.size() == length) {
+      return true;  // The match reaches the end of the query
+    }
+    return std::search(text.begin(), text.end(), pattern.begin(),
+                       pattern.end()) == text.end();
+  }
+
+public:
+  std::string file_path;
+  std::string query_path;
+  uint64_t prefix_length = 0;
+  std::string algorithm = "s_par";
+  uint64_t block_size = uint64_t{1} << 24;
+  uint64_t chunk_size = uint64_t{1} << 16;
+  uint64_t check_every = 0;
+  std::string huge_pages = "off";
+}; // class matching_statistics_benchmark
+
+int32_t main(int argc, char *argv[]) {
+  matching_statistics_benchmark bench;
+
+  tlx::CmdlineParser cp;
+  cp.set_description("Computes the matching statistics of a query with "
+                     "respect to a text, i.e., for each query position the "
+                     "length of the longest prefix that occurs in the text.");
+  cp.set_author("Alexander Herlez <alexander.herlez@tu-dortmund.de>");
+
+  cp.add_param_string("file", bench.file_path, "The indexed text");
+  cp.add_param_string("query", bench.query_path, "The query, which is "
+                      "streamed from the file");
+  cp.add_bytes('p', "pre", bench.prefix_length, "Size of the prefix of the "
+               "text in bytes that will be read (optional).");
+  cp.add_string('a', "algorithm", bench.algorithm, "LCE data structure: "
+                "[n]aive, [p]rezza, or parallel string synchronizing sets "
+                "[s256_par], [s512_par] (default), [s1024_par], "
+                "[s2048_par].");
+  cp.add_bytes('b', "block_size", bench.block_size, "Bytes of the query that "
+               "are read at once (default=16Mi).");
+  cp.add_bytes('k', "chunk_size", bench.chunk_size, "Query positions per "
+               "parallel task (default=64Ki).");
+  cp.add_bytes('c', "check_every", bench.check_every, "Compare every k-th "
+               "result with a search in the text, 0 disables the check "
+               "(default).");
+  cp.add_string("huge_pages", bench.huge_pages, "Back the text and the large "
+                "arrays of parallel sss with huge pages: off (default), thp, "
+                "2m or 1g.");
+
+  if (!cp.process(argc, argv)) {
+    std::exit(EXIT_FAILURE);
+  }
+
+  lce_test::huge_page_mode huge_pages;
+  if (!lce_test::parse_huge_page_mode(bench.huge_pages, huge_pages)) {
+    std::cerr << "Unknown huge page mode " << bench.huge_pages << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+  lce_test::set_huge_page_mode(huge_pages);
+
+  bench.run();
+  return 0;
+}
@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <tlx/cmdline_parser.hpp>
+
+#include "io.hpp"
+#include "timer.hpp"
+#include "lce_multi_text.hpp"
+#include "lce_naive.hpp"
+#include "lce_prezza.hpp"
+#include "lce_semi_synchronizing_sets_par.hpp"
+
+/* Builds one LCE data structure over a collection of texts and answers
+ * random queries lce(a, i, b, j) between suffixes of any two texts. Every
+ * k-th query is checked against a naive comparison of untouched copies of
+ * the texts, which stops at the end of either text. */
+class multi_text_benchmark {
+
+public:
+  void run() {
+    if (algorithm == "n") {
+      run_backend([](std::vector<uint8_t>& text) {
+        return std::make_unique<LceNaive>(text);
+      });
+    } else if (algorithm == "p") {
+      run_backend([](std::vector<uint8_t>& text) {
+        return std::make_unique<LcePrezza<128>>(reinterpret_cast<uint64_t*>(text.data()),
+                                                text.size());
+      }, true);
+    } else if (algorithm == "s2048_par") {
+      run_sss_par<2048>();
+    } else if (algorithm == "s1024_par") {
+      run_sss_par<1024>();
+    } else if (algorithm == "s512_par" || algorithm == "s_par") {
+      run_sss_par<512>();
+    } else if (algorithm == "s256_par") {
+      run_sss_par<256>();
+    } else {
+      std::cerr << "Unknown algorithm " << algorithm << std::endl;
+    }
+  }
+
+private:
+  template <uint64_t kTau>
+  void run_sss_par() {
+    run_backend([](std::vector<uint8_t>& text) {
+      return std::make_unique<lce_test::par::LceSemiSyncSetsPar<kTau>>(text, false);
+    });
+  }
+
+  template <typename builder_type>
+  void run_backend(builder_type&& build, bool const pad_text_to_words = false) {
+    std::vector<std::vector<uint8_t>> texts;
+    for (auto const& file_path : file_paths) {
+      texts.push_back(load_text(file_path, prefix_length));
+      if (texts.back().empty()) {
+        std::cerr << "Empty text " << file_path << std::endl;
+        return;
+      }
+    }
+    if (texts.empty()) {
+      std::cerr << "No texts" << std::endl;
+      return;
+    }
+    std::vector<std::vector<uint8_t>> check_texts;
+    if (check_every > 0) {
+      check_texts = texts;
+    }
+    uint64_t total_size = 0;
+    for (auto const& text : texts) {
+      total_size += text.size();
+    }
+
+    timer t;
+    lce_test::LceMultiText const lce_ds(std::move(texts), build, pad_text_to_words);
+    size_t const construction_time = t.get_and_reset();
+
+    // The queries are drawn first, so only the LCE queries are timed
+    std::mt19937_64 gen(seed);
+    std::uniform_int_distribution<size_t> text_dist(0, lce_ds.num_texts() - 1);
+    std::vector<size_t> query_texts(2 * number_queries);
+    std::vector<uint64_t> query_positions(2 * number_queries);
+    for (size_t k = 0; k < 2 * number_queries; ++k) {
+      query_texts[k] = text_dist(gen);
+      query_positions[k] = std::uniform_int_distribution<uint64_t>(
+          0, lce_ds.text_size(query_texts[k]) - 1)(gen);
+    }
+
+    std::vector<uint64_t> results(number_queries);
+    t.reset();
+    for (size_t q = 0; q < number_queries; ++q) {
+      results[q] = lce_ds.lce(query_texts[2 * q], query_positions[2 * q],
+                              query_texts[2 * q + 1], query_positions[2 * q + 1]);
+    }
+    size_t const query_time = t.get_and_reset();
+
+    uint64_t lce_sum = 0;
+    uint64_t checked_queries = 0;
+    uint64_t wrong_queries = 0;
+    for (size_t q = 0; q < number_queries; ++q) {
+      lce_sum += results[q];
+      if (check_every > 0 && q % check_every == 0) {
+        auto const& a = check_texts[query_texts[2 * q]];
+        auto const& b = check_texts[query_texts[2 * q + 1]];
+        uint64_t const i = query_positions[2 * q];
+        uint64_t const j = query_positions[2 * q + 1];
+        uint64_t const max_length = std::min(a.size() - i, b.size() - j);
+        uint64_t lce = 0;
+        while (lce < max_length && a[i + lce] == b[j + lce]) {
+          ++lce;
+        }
+        ++checked_queries;
+        wrong_queries += (results[q] != lce);
+      }
+    }
+
+    std::cout << "RESULT "
+              << "algo=" << algorithm << "_multi_text "
+              << "texts=" << lce_ds.num_texts() << " "
+              << "size=" << total_size << " "
+              << "queries=" << number_queries << " "
+              << "construction_time=" << construction_time << " "
+              << "lce_size=" << lce_ds.getSizeInBytes() << " "
+              << "query_time=" << query_time << " "
+              << "lce_sum=" << lce_sum << " "
+              << "checked=" << checked_queries << " "
+              << "check=" << (wrong_queries == 0 ? "passed" :
+                              "failed(" + std::to_string(wrong_queries) + ")")
+              << std::endl;
+  }
+
+public:
+  std::vector<std::string> file_paths;
+  uint64_t prefix_length = 0;
+  std::string algorithm = "p";
+  uint64_t number_queries = 1000000;
+  uint64_t check_every = 1;
+  uint64_t seed = 42;
+}; // class multi_text_benchmark
+
+int32_t main(int argc, char *argv[]) {
+  multi_text_benchmark bench;
+
+  tlx::CmdlineParser cp;
+  cp.set_description("Builds one LCE data structure over several texts and "
+                     "answers random LCE queries between suffixes of any two "
+                     "of them.");
+  cp.set_author("Alexander Herlez <alexander.herlez@tu-dortmund.de>");
+
+  cp.add_param_stringlist("files", bench.file_paths, "The texts which are "
+                          "queried");
+  cp.add_bytes('p', "pre", bench.prefix_length, "Size of the prefix in bytes "
+               "that will be read of each text (optional).");
+  cp.add_string('a', "algorithm", bench.algorithm, "LCE data structure: "
+                "[n]aive, [p]rezza (default), or parallel string "
+                "synchronizing sets [s256_par], [s512_par], [s1024_par], "
+                "[s2048_par].");
+  cp.add_bytes('q', "queries", bench.number_queries, "Number of LCE queries "
+               "(default=1,000,000).");
+  cp.add_bytes('c', "check_every", bench.check_every, "Compare every k-th "
+               "query with the naive LCE, 0 disables the check (default=1).");
+  cp.add_bytes('s', "seed", bench.seed, "Seed of the random queries.");
+
+  if (!cp.process(argc, argv)) {
+    std::exit(EXIT_FAILURE);
+  }
+
+  bench.run();
+  return 0;
+}
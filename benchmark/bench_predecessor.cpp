@@ -28,6 +28,7 @@
 
 #ifdef ALLOW_PARALLEL
 #include "util/successor/index_par.hpp"
+#include "util/successor/sss_index.hpp"
 #endif
 
 uint64_t time() {
@@ -65,6 +66,8 @@ using j_index = pred::j_index<std::vector<value_t>, value_t>;
 #ifdef ALLOW_PARALLEL
 template<size_t k>
 using index_par = pred::index_par<std::vector<value_t>, value_t, k>;
+template<uint64_t tau>
+using sss_index = pred::sss_index<std::vector<value_t>, value_t, tau>;
 #endif
 
 template<size_t epsilon>
@@ -300,6 +303,9 @@ int main(int argc, char** argv) {
     print_result("idx<14>", test_successor<index_par<14>>(array, queries));
     print_result("idx<15>", test_successor<index_par<15>>(array, queries));
     print_result("idx<16>", test_successor<index_par<16>>(array, queries));
+    print_result("sss<256>", test_successor<sss_index<256>>(array, queries));
+    print_result("sss<512>", test_successor<sss_index<512>>(array, queries));
+    print_result("sss<1024>", test_successor<sss_index<1024>>(array, queries));
     #else
     print_result("bs", test_successor<binsearch>(array, queries));
     print_result("bs*", test_successor<binsearch_cache>(array, queries));
@@ -0,0 +1,144 @@
+#include <malloc_count.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <tlx/cmdline_parser.hpp>
+
+#include "io.hpp"
+#include "timer.hpp"
+#include "lce_prezza.hpp"
+#include "lce_runs.hpp"
+#include "lce_semi_synchronizing_sets_par.hpp"
+#include "util/huge_pages.hpp"
+
+/* Computes the runs of a text using forward and backward LCE queries and
+ * optionally writes them to a file (three 64-bit integers start, length and
+ * period per run). */
+class runs_benchmark {
+
+public:
+  void run() {
+    if (algorithm == "p") {
+      std::vector<uint8_t> text = load_text(file_path, prefix_length);
+      uint64_t const text_size = text.size();
+      timer t;
+      text.resize(text.size() + (8 - (text.size() % 8)));
+      LcePrezza<128> const lce_ds(reinterpret_cast<uint64_t*>(text.data()), text.size());
+      compute(lce_ds, text_size, t);
+    } else if (algorithm == "s2048_par") {
+      run_sss_par<2048>();
+    } else if (algorithm == "s1024_par") {
+      run_sss_par<1024>();
+    } else if (algorithm == "s512_par" || algorithm == "s_par") {
+      run_sss_par<512>();
+    } else if (algorithm == "s256_par") {
+      run_sss_par<256>();
+    } else {
+      std::cerr << "Unknown algorithm " << algorithm << std::endl;
+    }
+  }
+
+private:
+  template <uint64_t kTau>
+  void run_sss_par() {
+    std::vector<uint8_t> const text = load_text(file_path, prefix_length);
+    timer t;
+    lce_test::par::LceSemiSyncSetsPar<kTau> lce_ds(text, false);
+    lce_ds.build_backward();
+    compute(lce_ds, text.size(), t);
+  }
+
+  template <typename backend_type>
+  void compute(backend_type const& lce_ds, uint64_t const text_size, timer& t) {
+    size_t const construction_time = t.get_and_reset();
+
+    std::ofstream out;
+    if (!output_path.empty()) {
+      out.open(output_path, std::ios::out | std::ios::binary | std::ios::trunc);
+    }
+    uint64_t max_length = 0;
+    uint64_t covered = 0;
+
+    uint64_t const num_runs = lce_test::compute_runs(lce_ds, text_size,
+        [&](std::span<lce_test::text_run const> const runs) {
+      if (out.is_open()) {
+        out.write(reinterpret_cast<char const*>(runs.data()), runs.size_bytes());
+      }
+      for (auto const& run : runs) {
+        max_length = std::max(max_length, run.length);
+        covered += run.length;
+      }
+    }, min_period, max_period);
+    size_t const runs_time = t.get_and_reset();
+
+    std::cout << "RESULT "
+              << "algo=" << algorithm << "_runs "
+              << "input=" << file_path << " "
+              << "size=" << text_size << " "
+              << "min_period=" << min_period << " "
+              << "max_period=" << max_period << " "
+              << "construction_time=" << construction_time << " "
+              << "runs_time=" << runs_time << " "
+              << "lce_size=" << lce_ds.getSizeInBytes() << " "
+              << "runs=" << num_runs << " "
+              << "runs_length_sum=" << covered << " "
+              << "runs_length_max=" << max_length
+              << std::endl;
+  }
+
+public:
+  std::string file_path;
+  std::string output_path;
+  uint64_t prefix_length = 0;
+  std::string algorithm = "s_par";
+  uint64_t min_period = 1;
+  uint64_t max_period = std::numeric_limits<uint64_t>::max();
+  std::string huge_pages = "off";
+}; // class runs_benchmark
+
+int32_t main(int argc, char *argv[]) {
+  runs_benchmark bench;
+
+  tlx::CmdlineParser cp;
+  cp.set_description("Computes all runs (maximal repetitions) of a text with "
+                     "forward and backward LCE queries.");
+  cp.set_author("Alexander Herlez <alexander.herlez@tu-dortmund.de>");
+
+  cp.add_param_string("file", bench.file_path, "The text");
+  cp.add_string('o', "output", bench.output_path, "File the runs are written "
+                "to, three 64-bit integers (start, length, period) each "
+                "(optional).");
+  cp.add_bytes('p', "pre", bench.prefix_length, "Size of the prefix in bytes "
+               "that will be read (optional).");
+  cp.add_string('a', "algorithm", bench.algorithm, "LCE data structure: "
+                "[p]rezza, or parallel string synchronizing sets [s256_par], "
+                "[s512_par] (default), [s1024_par], [s2048_par].");
+  cp.add_bytes("min_period", bench.min_period, "Smallest reported period "
+               "(default=1).");
+  cp.add_bytes("max_period", bench.max_period, "Largest reported period "
+               "(default=n/2).");
+  cp.add_string("huge_pages", bench.huge_pages, "Back the text and the large "
+                "arrays of parallel sss with huge pages: off (default), thp, "
+                "2m or 1g.");
+
+  if (!cp.process(argc, argv)) {
+    std::exit(EXIT_FAILURE);
+  }
+
+  lce_test::huge_page_mode huge_pages;
+  if (!lce_test::parse_huge_page_mode(bench.huge_pages, huge_pages)) {
+    std::cerr << "Unknown huge page mode " << bench.huge_pages << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+  lce_test::set_huge_page_mode(huge_pages);
+
+  bench.run();
+  return 0;
+}
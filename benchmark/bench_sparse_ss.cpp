@@ -16,6 +16,7 @@
 #include "lce_prezza.hpp"
 #include "lce_semi_synchronizing_sets_par.hpp"
 #include "timer.hpp"
+#include "util/lce_backend.hpp"
 
 int main(int argc, char** argv) {
   if (argc != 4) {
@@ -68,16 +69,7 @@ int main(int argc, char** argv) {
     auto mem_before = malloc_count_current();
     timer t;
     LceNaive lce_ds(text);
-    std::sort(positions.begin(), positions.end(), [&lce_ds, &text_size, &text](size_t i, size_t j) {
-      size_t lce = lce_ds.lce(i, j);
-      if (i + lce >= text_size) {
-        return true;
-      }
-      if (j + lce >= text_size) {
-        return false;
-      }
-      return text[i + lce] < text[j + lce];
-    });
+    std::sort(positions.begin(), positions.end(), lce_test::suffix_comparator(lce_ds, text_size));
     std::cout << "RESULT algo=naive_ips4o time=" << t.get_and_reset()
               << " sample_distance=" << sample_distance
               << " text_name=" << text_name
@@ -113,16 +105,7 @@ int main(int argc, char** argv) {
     auto constr_time = t.get();
 
     timer t_sort;
-    std::sort(positions.begin(), positions.end(), [&lce_ds, &text_size, &text](size_t i, size_t j) {
-      size_t lce = lce_ds.lce(i, j);
-      if (i + lce >= text_size) [[unlikely]] {
-        return true;
-      }
-      if (j + lce >= text_size) [[unlikely]] {
-        return false;
-      }
-      return lce_ds[i + lce] < lce_ds[j + lce];
-    });
+    std::sort(positions.begin(), positions.end(), lce_test::suffix_comparator(lce_ds, text_size));
     auto sort_time = t_sort.get();
 
     timer t_reconstruct;
@@ -147,16 +130,7 @@ int main(int argc, char** argv) {
     timer t;
     lce_test::par::LceSemiSyncSetsPar<256> lce_ds(text, false);
     auto constr_time = t.get();
-    std::sort(positions.begin(), positions.end(), [&lce_ds, &text_size, &text](size_t i, size_t j) {
-      size_t lce = lce_ds.lce(i, j);
-      if (i + lce >= text_size) [[unlikely]] {
-        return true;
-      }
-      if (j + lce >= text_size) [[unlikely]] {
-        return false;
-      }
-      return text[i + lce] < text[j + lce];
-    });
+    std::sort(positions.begin(), positions.end(), lce_test::suffix_comparator(lce_ds, text_size));
     std::cout << "RESULT algo=sss256_ips4o time=" << t.get_and_reset()
               << " sample_distance=" << sample_distance
               << " text_name=" << text_name
@@ -171,16 +145,7 @@ int main(int argc, char** argv) {
     timer t;
     lce_test::par::LceSemiSyncSetsPar<512> lce_ds(text, false);
     auto constr_time = t.get();
-    std::sort(positions.begin(), positions.end(), [&lce_ds, &text_size, &text](size_t i, size_t j) {
-      size_t lce = lce_ds.lce(i, j);
-      if (i + lce >= text_size) [[unlikely]] {
-        return true;
-      }
-      if (j + lce >= text_size) [[unlikely]] {
-        return false;
-      }
-      return text[i + lce] < text[j + lce];
-    });
+    std::sort(positions.begin(), positions.end(), lce_test::suffix_comparator(lce_ds, text_size));
     std::cout << "RESULT algo=sss512_ips4o time=" << t.get_and_reset()
               << " sample_distance=" << sample_distance
               << " text_name=" << text_name
@@ -195,16 +160,7 @@ int main(int argc, char** argv) {
     timer t;
     lce_test::par::LceSemiSyncSetsPar<1024> lce_ds(text, false);
     auto constr_time = t.get();
-    std::sort(positions.begin(), positions.end(), [&lce_ds, &text_size, &text](size_t i, size_t j) {
-      size_t lce = lce_ds.lce(i, j);
-      if (i + lce >= text_size) [[unlikely]] {
-        return true;
-      }
-      if (j + lce >= text_size) [[unlikely]] {
-        return false;
-      }
-      return text[i + lce] < text[j + lce];
-    });
+    std::sort(positions.begin(), positions.end(), lce_test::suffix_comparator(lce_ds, text_size));
     std::cout << "RESULT algo=sss1024_ips4o time=" << t.get_and_reset()
               << " sample_distance=" << sample_distance
               << " text_name=" << text_name
@@ -219,16 +175,7 @@ int main(int argc, char** argv) {
     timer t;
     lce_test::par::LceSemiSyncSetsPar<2048> lce_ds(text, false);
     auto constr_time = t.get();
-    std::sort(positions.begin(), positions.end(), [&lce_ds, &text_size, &text](size_t i, size_t j) {
-      size_t lce = lce_ds.lce(i, j);
-      if (i + lce >= text_size) [[unlikely]] {
-        return true;
-      }
-      if (j + lce >= text_size) [[unlikely]] {
-        return false;
-      }
-      return text[i + lce] < text[j + lce];
-    });
+    std::sort(positions.begin(), positions.end(), lce_test::suffix_comparator(lce_ds, text_size));
     std::cout << "RESULT algo=sss2048_ips4o time=" << t.get_and_reset()
               << " sample_distance=" << sample_distance
               << " text_name=" << text_name
@@ -10,7 +10,9 @@
 
 #include <malloc_count.h>
 
+#include <chrono>
 #include <fstream>
+#include <random>
 #include <sys/time.h>
 #include <vector>
 #include <iomanip>
@@ -18,16 +20,20 @@
 #include <filesystem>
 
 #include <memory>
+#include <type_traits>
 
 #include <tlx/cmdline_parser.hpp>
 #include <tlx/math/aggregate.hpp>
 
 #include "io.hpp"
+#include "util/huge_pages.hpp"
+#include "util/lce_backend.hpp"
 #include "timer.hpp"
 #include "build_lce_ranges.hpp"
 #include "lce_naive.hpp"
 #include "lce_naive_ultra.hpp"
 #include "lce_prezza.hpp"
+#include "lce_prezza_dynamic.hpp"
 #include "lce_prezza_mersenne.hpp"
 #include "lce_semi_synchronizing_sets.hpp"
 
@@ -44,6 +50,112 @@ class lce_benchmark {
 
 public:
   void run() {
+    if (algorithm == "u") {
+      run_backend([](std::vector<uint8_t>& text, bool) {
+        return std::make_unique<LceUltraNaive>(text);
+      });
+    } else if (algorithm == "n") {
+      run_backend([](std::vector<uint8_t>& text, bool) {
+        return std::make_unique<LceNaive>(text);
+      });
+    } else if (algorithm == "m") {
+      run_backend([](std::vector<uint8_t>& text, bool) {
+        return std::make_unique<rklce::LcePrezzaMersenne>(text);
+      });
+    } else if (algorithm == "p") {
+      // Make sure the text can be divided into 64 bit blocks
+      run_backend([](std::vector<uint8_t>& text, bool) {
+        return std::make_unique<LcePrezza<128>>(reinterpret_cast<uint64_t*>(text.data()),
+                                                text.size());
+      }, true);
+    } else if (algorithm == "pm") {
+      run_backend([](std::vector<uint8_t>& text, bool) {
+        return std::make_unique<LcePrezza<128, lce_test::fingerprint_pseudo_mersenne<>>>(
+            reinterpret_cast<uint64_t*>(text.data()), text.size());
+      }, true);
+    } else if (algorithm == "pr") {
+      run_backend([this](std::vector<uint8_t>& text, bool) {
+        lce_test::fingerprint_montgomery const fingerprint =
+            (prime != 0) ? lce_test::fingerprint_montgomery(prime)
+                         : lce_test::fingerprint_montgomery();
+        return std::make_unique<LcePrezza<128, lce_test::fingerprint_montgomery>>(
+            reinterpret_cast<uint64_t*>(text.data()), text.size(), fingerprint);
+      }, true);
+    } else if (algorithm == "pd") {
+      run_backend([](std::vector<uint8_t>& text, bool) {
+        return std::make_unique<LcePrezzaDynamic<128>>(reinterpret_cast<uint64_t*>(text.data()),
+                                                       text.size());
+      }, true);
+    } else if (algorithm == "s2048") {
+      run_sss<2048>();
+    } else if (algorithm == "s1024") {
+      run_sss<1024>();
+    } else if (algorithm == "s512" || algorithm == "s") {
+      run_sss<512>();
+    } else if (algorithm == "s256") {
+      run_sss<256>();
+    }
+#ifdef ALLOW_PARALLEL
+    else if (algorithm == "s2048_par") {
+      run_sss_par<2048>();
+    } else if (algorithm == "s1024_par") {
+      run_sss_par<1024>();
+    } else if (algorithm == "s512_par" || algorithm == "s_par") {
+      run_sss_par<512>();
+    } else if (algorithm == "s256_par") {
+      run_sss_par<256>();
+    }
+#endif
+#ifdef LCE_BUILD_SDSL
+    else if (algorithm == "sada" || algorithm == "sct3") {
+      fs::path const text_path(file_path);
+      run_backend([text_path](std::vector<uint8_t>&, bool) {
+        return std::make_unique<LceSDSLsada>(text_path);
+      });
+      //sdsl::ram_fs::remove(tmp_file);
+    }
+#endif
+  }
+
+private:
+  template <uint64_t kTau>
+  void run_sss() {
+    if (prefer_long_queries) {
+      run_backend([](std::vector<uint8_t>& text, bool const print_ss_size) {
+        return std::make_unique<LceSemiSyncSets<kTau, true>>(text, print_ss_size);
+      });
+    } else {
+      run_backend([](std::vector<uint8_t>& text, bool const print_ss_size) {
+        return std::make_unique<LceSemiSyncSets<kTau, false>>(text, print_ss_size);
+      });
+    }
+  }
+
+#ifdef ALLOW_PARALLEL
+  template <uint64_t kTau>
+  void run_sss_par() {
+    lce_test::par::sss_ranking const sss_ranking = (ranking == "fingerprint")
+                                                       ? lce_test::par::sss_ranking::fingerprints
+                                                       : lce_test::par::sss_ranking::string_sort;
+    run_backend([this, sss_ranking](std::vector<uint8_t>& text, bool const print_ss_size) {
+      auto lce_sss = std::make_unique<lce_test::par::LceSemiSyncSetsPar<kTau>>(text, print_ss_size, sss_ranking);
+      if (numa_replicas) {
+        lce_sss->replicate_numa();
+      }
+      if (hybrid) {
+        lce_sss->build_fingerprints();
+      }
+      return lce_sss;
+    });
+  }
+#endif
+
+  /* Measures construction and queries of the data structure returned by
+     build(text, print_ss_size). The data structure is used via its static
+     type, so all queries are resolved (and possibly inlined) at compile
+     time. */
+  template <typename builder_type>
+  void run_backend(builder_type&& build, bool const pad_text_to_words = false) {
  
     fs::path text_path(file_path);
     std::string const filename = text_path.filename();
@@ -73,7 +185,10 @@ public:
      ****PREPARE LCE DATA STRUCTURES*****
      ************************************/
 
-    std::unique_ptr<LceDataStructure> lce_structure;
+    using backend_type =
+        typename std::invoke_result_t<builder_type&, std::vector<uint8_t>&, bool>::element_type;
+    static_assert(lce_test::LceBackend<backend_type>);
+    std::unique_ptr<backend_type> lce_structure;
     std::vector<uint8_t> text;
 
     timer t;
@@ -87,158 +202,24 @@ public:
 
     for (size_t i = 0; i < runs; ++i) {
       text = load_text(text_path, prefix_length);
-
-      auto* old_structure = lce_structure.release();
-      if (old_structure != nullptr) {
-        delete old_structure;
-      }
-      if (algorithm == "u") {
-        size_t const mem_before = malloc_count_current();
-        t.reset();
-        lce_structure = std::make_unique<LceUltraNaive>(text);
-        construction_times.add(t.get_and_reset());
-        lce_mem.add(malloc_count_current() - mem_before);
-        construction_mem_peak.add(malloc_count_peak() - mem_before);
-      } else if (algorithm == "n") {
-        size_t const mem_before = malloc_count_current();
-        t.reset();
-        lce_structure = std::make_unique<LceNaive>(text);
-        construction_times.add(t.get_and_reset());
-        lce_mem.add(malloc_count_current() - mem_before);
-        construction_mem_peak.add(malloc_count_peak() - mem_before);
-      } else if (algorithm == "m") {
-        t.reset();
-        lce_structure = std::make_unique<rklce::LcePrezzaMersenne>(text);
-        construction_times.add(t.get_and_reset());
-      } else if (algorithm == "p") {
-        // Make sure the text can be divided into 64 bit blocks
+      if (pad_text_to_words) {
         text.resize(text.size() + (8 - (text.size() % 8)));
-        size_t const mem_before = malloc_count_current();
-        t.reset();
-        lce_structure =
-          std::make_unique<LcePrezza<128>>(reinterpret_cast<uint64_t*>(text.data()),
-                                      text.size());
-        construction_times.add(t.get_and_reset());
-        lce_mem.add(malloc_count_current() - mem_before);
-        construction_mem_peak.add(malloc_count_peak() - mem_before);
-      } else if (algorithm == "s2048") {
-        size_t const mem_before = malloc_count_current();
-        t.reset();
-        if (prefer_long_queries) {
-          lce_structure = std::make_unique<LceSemiSyncSets<2048, true>>(text, i == 0);
-        } else {
-          lce_structure = std::make_unique<LceSemiSyncSets<2048, false>>(text, i == 0);
-        }
-        construction_times.add(t.get_and_reset());
-        lce_mem.add(malloc_count_current() - mem_before);
-        construction_mem_peak.add(malloc_count_peak() - mem_before);
-      } else if (algorithm == "s1024") {
-        size_t const mem_before = malloc_count_current();
-        t.reset();
-        if (prefer_long_queries) {
-          lce_structure = std::make_unique<LceSemiSyncSets<1024, true>>(text, i == 0);
-        } else {
-          lce_structure = std::make_unique<LceSemiSyncSets<1024, false>>(text, i == 0);
-        }
-        construction_times.add(t.get_and_reset());
-        lce_mem.add(malloc_count_current() - mem_before);
-        construction_mem_peak.add(malloc_count_peak() - mem_before);
-        construction_mem_peak.add(malloc_count_peak() - mem_before);
-      } else if (algorithm == "s512" || algorithm == "s") {
-        size_t const mem_before = malloc_count_current();
-        t.reset();
-        if (prefer_long_queries) {
-          lce_structure = std::make_unique<LceSemiSyncSets<512, true>>(text, i == 0);
-        } else {
-          lce_structure = std::make_unique<LceSemiSyncSets<512, false>>(text, i == 0);
-        }
-        construction_times.add(t.get_and_reset());
-        lce_mem.add(malloc_count_current() - mem_before);
-        construction_mem_peak.add(malloc_count_peak() - mem_before);
-      } else if (algorithm == "s256") {
-        size_t const mem_before = malloc_count_current();
-        t.reset();
-        if (prefer_long_queries) {
-          lce_structure = std::make_unique<LceSemiSyncSets<256, true>>(text, i == 0);
-        } else {
-          lce_structure = std::make_unique<LceSemiSyncSets<256, false>>(text, i == 0);
-        }
-        construction_times.add(t.get_and_reset());
-        lce_mem.add(malloc_count_current() - mem_before);
-        construction_mem_peak.add(malloc_count_peak() - mem_before);
       }
-#ifdef ALLOW_PARALLEL
-      else if (algorithm == "s2048_par") {
-        size_t const mem_before = malloc_count_current();
-        t.reset();
-        if (prefer_long_queries) {
-          lce_structure = std::make_unique<lce_test::par::LceSemiSyncSetsPar<2048>>(text, i == 0);
-        } else {
-          lce_structure = std::make_unique<lce_test::par::LceSemiSyncSetsPar<2048>>(text, i == 0);
-        }
-        construction_times.add(t.get_and_reset());
-        lce_mem.add(malloc_count_current() - mem_before);
-        construction_mem_peak.add(malloc_count_peak() - mem_before);
-      } else if (algorithm == "s1024_par") {
-        size_t const mem_before = malloc_count_current();
-        t.reset();
-        if (prefer_long_queries) {
-          lce_structure = std::make_unique<lce_test::par::LceSemiSyncSetsPar<1024>>(text, i == 0);
-        } else {
-          lce_structure = std::make_unique<lce_test::par::LceSemiSyncSetsPar<1024>>(text, i == 0);
-        }
-        construction_times.add(t.get_and_reset());
-        lce_mem.add(malloc_count_current() - mem_before);
-        construction_mem_peak.add(malloc_count_peak() - mem_before);
-        construction_mem_peak.add(malloc_count_peak() - mem_before);
-      } else if (algorithm == "s512_par" || algorithm == "s_par") {
-        size_t const mem_before = malloc_count_current();
-        t.reset();
-        if (prefer_long_queries) {
-          lce_structure = std::make_unique<lce_test::par::LceSemiSyncSetsPar<512>>(text, i == 0);
-        } else {
-          lce_structure = std::make_unique<lce_test::par::LceSemiSyncSetsPar<512>>(text, i == 0);
-        }
-        construction_times.add(t.get_and_reset());
-        lce_mem.add(malloc_count_current() - mem_before);
-        construction_mem_peak.add(malloc_count_peak() - mem_before);
-      } else if (algorithm == "s256_par") {
-        size_t const mem_before = malloc_count_current();
-        t.reset();
-        if (prefer_long_queries) {
-          lce_structure = std::make_unique<lce_test::par::LceSemiSyncSetsPar<256>>(text, i == 0);
-        } else {
-          lce_structure = std::make_unique<lce_test::par::LceSemiSyncSetsPar<256>>(text, i == 0);
-        }
-        construction_times.add(t.get_and_reset());
-        lce_mem.add(malloc_count_current() - mem_before);
-        construction_mem_peak.add(malloc_count_peak() - mem_before);
-      }
-#endif
 
-#ifdef LCE_BUILD_SDSL
-      else if (algorithm == "sada") {
-        size_t const mem_before = malloc_count_current();
-        t.reset();
-        lce_structure = std::make_unique<LceSDSLsada>(text_path);
-        construction_times.add(t.get_and_reset());
-        lce_mem.add(malloc_count_current() - mem_before);
-        construction_mem_peak.add(malloc_count_peak() - mem_before);
-        //sdsl::ram_fs::remove(tmp_file);
-      } else if (algorithm == "sct3") {
-        size_t const mem_before = malloc_count_current();
-        t.reset();
-        lce_structure = std::make_unique<LceSDSLsada>(text_path);
-        construction_times.add(t.get_and_reset());
-        lce_mem.add(malloc_count_current() - mem_before);
-        construction_mem_peak.add(malloc_count_peak() - mem_before);
-      }
-#endif
-      else {
-        return;
-      }
+      lce_structure.reset();
+      size_t const mem_before = malloc_count_current();
+      t.reset();
+      lce_structure = build(text, i == 0);
+      construction_times.add(t.get_and_reset());
+      lce_mem.add(malloc_count_current() - mem_before);
+      construction_mem_peak.add(malloc_count_peak() - mem_before);
     }
 
+    // Timings and memory of the construction phases of the last run
+    std::cout << lce_test::phase_profile_of(*lce_structure);
+    // Space of the components (independent of malloc_count)
+    std::cout << lce_structure->memory_breakdown();
+
     std::cout << "construction_min_time=" << construction_times.min() << " "
               << "construction_max_time=" << construction_times.max() << " "
               << "construction_avg_time=" << construction_times.avg() << " "
@@ -246,8 +227,13 @@ public:
               << "input=" << text_path << " "
               << "size=" << text.size() << " "
 
+              << "lce_size=" << lce_structure->getSizeInBytes() << " "
+              #ifndef ALLOW_PARALLEL
+              // malloc_count is only linked in sequential builds
               << "lce_mem=" << lce_mem.max() << " "
               << "construction_mem_peak=" << construction_mem_peak.max() << " "
+              #endif
+              << "huge_pages=" << huge_pages << " "
               #ifdef ALLOW_PARALLEL
               << "threads=" << omp_get_max_threads() << " "
               #endif
@@ -255,6 +241,7 @@ public:
     std::cout << std::endl;
 
     std::vector<uint64_t> lce_indices(number_lce_queries * 2);
+    std::vector<uint64_t> lce_results(number_lce_queries);
     bool correct = true;
     size_t wrong_queries = 0;
 
@@ -265,6 +252,8 @@ public:
                 << "algo=" << print_algo_name() << "_queries "
                 << "runs=" << runs << " "
                 << "length_exp=" << i << " "
+                << "cap=" << lce_cap << " "
+                << "batch=" << batch << " "
                 << "input=" << text_path << " "
                 << "size=" << text.size() << " ";
       vector<uint64_t> v;
@@ -284,22 +273,32 @@ public:
         }
         for (size_t i = 0; i < runs; ++i) {
           t.reset();
-          for (size_t j = 0; j < number_lce_queries * 2; j += 2) {
-            size_t const lce = lce_structure->lce(lce_indices[j],
-                                                  lce_indices[j + 1]);
-            lce_values.add(lce);
+          if (lce_cap > 0) {
+            for (size_t k = 0; k < number_lce_queries; ++k) {
+              lce_results[k] = lce_structure->lce_bounded(
+                  lce_indices[2 * k], lce_indices[2 * k + 1], lce_cap);
+            }
+          } else if (batch) {
+            lce_test::lce_batch(*lce_structure, lce_indices, lce_results);
+          } else {
+            for (size_t k = 0; k < number_lce_queries; ++k) {
+              lce_results[k] = lce_structure->lce(lce_indices[2 * k], lce_indices[2 * k + 1]);
+            }
           }
           queries_times.add(t.get_and_reset());
+          for (uint64_t const lce : lce_results) {
+            lce_values.add(lce);
+          }
         }
         if (check) {
           correct = true;
           auto check_text = load_text(text_path, prefix_length);
           auto lce_naive = LceUltraNaive(check_text);
           for (size_t j = 0; j < number_lce_queries * 2; j += 2) {
-            size_t const lce = lce_structure->lce(lce_indices[j],
-                                                  lce_indices[j + 1]);
-            size_t const lce_res_naive = lce_naive.lce(lce_indices[j],
-                                                        lce_indices[j + 1]);
+            size_t const lce = lce_results[j / 2];
+            size_t const lce_res_naive = (lce_cap > 0) ?
+                lce_naive.lce_bounded(lce_indices[j], lce_indices[j + 1], lce_cap) :
+                lce_naive.lce(lce_indices[j], lce_indices[j + 1]);
             if (lce != lce_res_naive) {
               correct = false;
               ++wrong_queries;
@@ -320,6 +319,78 @@ public:
                               + ")" )) : "none") << " "
                 << std::endl;
     }
+
+    if constexpr (requires { lce_structure->update(uint64_t{0}, char{0}); }) {
+      if (number_updates > 0) {
+        run_updates(*lce_structure, text_path, pad_text_to_words);
+      }
+    }
+  }
+
+  /* Edit workload of data structures with point edits update(i, c): random
+     updates, each followed by random queries, which are compared with the
+     naive LCE of an edited copy of the text. Each update is timed. */
+  template <typename lce_type>
+  void run_updates(lce_type& lce_structure, fs::path const& text_path,
+                   bool const pad_text_to_words) {
+    std::vector<uint8_t> check_text = load_text(text_path, prefix_length);
+    uint64_t const text_size = check_text.size();
+    if (text_size == 0) {
+      return;
+    }
+    // The data structure indexes the padded text, so does the naive LCE
+    if (pad_text_to_words) {
+      check_text.resize(check_text.size() + (8 - (check_text.size() % 8)));
+    }
+    LceUltraNaive const lce_naive(check_text);
+
+    std::mt19937_64 gen(42);
+    std::uniform_int_distribution<uint64_t> dist(0, text_size - 1);
+    tlx::Aggregate<size_t> update_times;
+    size_t query_time = 0;
+    size_t wrong_queries = 0;
+    uint64_t lce_sum = 0;
+
+    for (size_t u = 0; u < number_updates; ++u) {
+      uint64_t const i = dist(gen);
+      // Characters of the text, so edits also create matches
+      uint8_t const c = check_text[dist(gen)];
+      auto const update_begin = std::chrono::steady_clock::now();
+      lce_structure.update(i, static_cast<char>(c));
+      auto const update_end = std::chrono::steady_clock::now();
+      update_times.add(std::chrono::duration_cast<std::chrono::nanoseconds>(
+          update_end - update_begin).count());
+      check_text[i] = c;
+
+      for (size_t q = 0; q < queries_per_update; ++q) {
+        uint64_t const a = dist(gen);
+        uint64_t const b = dist(gen);
+        auto const query_begin = std::chrono::steady_clock::now();
+        uint64_t const lce = lce_structure.lce(a, b);
+        auto const query_end = std::chrono::steady_clock::now();
+        query_time += std::chrono::duration_cast<std::chrono::nanoseconds>(
+            query_end - query_begin).count();
+        lce_sum += lce;
+        wrong_queries += (lce != lce_naive.lce(a, b));
+      }
+    }
+
+    uint64_t const number_queries = number_updates * queries_per_update;
+    std::cout << "RESULT "
+              << "algo=" << print_algo_name() << "_updates "
+              << "input=" << text_path << " "
+              << "size=" << text_size << " "
+              << "updates=" << number_updates << " "
+              << "queries=" << number_queries << " "
+              << "update_times_min=" << update_times.min() << " "
+              << "update_times_max=" << update_times.max() << " "
+              << "update_times_avg=" << update_times.avg() << " "
+              << "queries_time_avg="
+              << (number_queries > 0 ? query_time / number_queries : 0) << " "
+              << "lce_sum=" << lce_sum << " "
+              << "check=" << (wrong_queries == 0 ? "passed" :
+                              "failed(" + std::to_string(wrong_queries) + ")")
+              << std::endl;
   }
 
 
@@ -336,9 +407,21 @@ public:
   size_t number_lce_queries = 1000000;
   uint32_t runs = 5;
 
+  uint64_t lce_cap = 0;
+  bool batch = false;
+
   uint32_t lce_from = 0;
   uint32_t lce_to = 21;
 
+  size_t number_updates = 0;
+  size_t queries_per_update = 10;
+
+  bool numa_replicas = false;
+  bool hybrid = false;
+  size_t prime = 0;
+  std::string ranking = "sort";
+  std::string huge_pages = "off";
+
 private:
   std::string print_algo_name() {
     std::string name("unknown");
@@ -350,6 +433,12 @@ private:
       name = "prezza_mersenne";
     } else if (algorithm == "p") {
       name = "prezza";
+    } else if (algorithm == "pm") {
+      name = "prezza_pseudo_mersenne";
+    } else if (algorithm == "pr") {
+      name = "prezza_random_prime";
+    } else if (algorithm == "pd") {
+      name = "prezza_dynamic";
     } else if (algorithm == "s2048") {
       name = "sss2048";
     } else if (algorithm == "s1024") {
@@ -398,18 +487,51 @@ int32_t main(int argc, char *argv[]) {
                "bytes that will be read (optional).");
   cp.add_string('a', "algorithm", lce_bench.algorithm, "LCE data structure "
                 "that is computed: [u]ltra naive (default), [n]aive, "
-                "prezza [m]ersenne, [p]rezza, or [s]tring synchronizing sets "
+                "prezza [m]ersenne, [p]rezza, [pm] prezza with pseudo-Mersenne "
+                "reduction, [pr] prezza with a random prime (Montgomery "
+                "reduction), [pd] prezza with updates, or [s]tring synchronizing sets "
                 "with tau = 512. [s2048], [s1024], [s512], [s256] for different "
                 "tau values. Suffix _par for parallel sss, e.g. [s256_par]");
   cp.add_flag('l', "long", lce_bench.prefer_long_queries, "Prefer long queries,"
               " i.e., queries with long LCE get faster, all other get slower. "
               "Only for [s]tring synchronizing sets.");
+  cp.add_string("huge_pages", lce_bench.huge_pages, "Back the text and the "
+                "large arrays of parallel sss with huge pages: off (default), "
+                "thp (transparent huge pages), 2m or 1g (reserved huge pages, "
+                "falling back to thp).");
+  cp.add_flag("numa", lce_bench.numa_replicas, "Replicate the query arrays "
+              "of parallel sss on each NUMA node. Queries use the replica of "
+              "the node they run on. Only for [s*_par].");
+  cp.add_flag("hybrid", lce_bench.hybrid, "Build fingerprints at the "
+              "positions of parallel sss, which answer queries with short "
+              "LCE without the RMQ. Only for [s*_par].");
+  cp.add_size_t("prime", lce_bench.prime, "Prime of [pr] instead of a "
+                "random one. It must be a prime in (2^63, 2^64), e.g., "
+                "18446744073709551557 = 2^64 - 59, which makes about half of "
+                "the fingerprints exceed 2^63 (to check their handling).");
+  cp.add_string("ranking", lce_bench.ranking, "How parallel sss ranks the "
+                "3*tau long strings at its positions: [sort] all strings "
+                "(default) or group equal strings by their [fingerprint] and "
+                "sort one per group. Only for [s*_par].");
   cp.add_flag('c', "check", lce_bench.check, "Check correctness of LCE queries "
               "by comparing with results of naive computation.");
   cp.add_bytes('q', "queries", lce_bench.number_lce_queries, "Number of LCE "
               "queries that are executed (default=1,000,000).");
   cp.add_uint('r', "runs", lce_bench.runs, "Number of runs that are used to "
               "report an average running time (default=5).");
+  cp.add_bytes("cap", lce_bench.lce_cap, "Answer bounded queries "
+               "min(LCE, cap) using lce_bounded (default=0, i.e., unbounded "
+               "queries).");
+  cp.add_bytes("updates", lce_bench.number_updates, "Number of random "
+               "updates update(i, c) after the queries, each followed by "
+               "random queries that are checked against the naive LCE of an "
+               "edited copy of the text. Times are in nanoseconds. Only for "
+               "[pd] (default=0).");
+  cp.add_bytes("update_queries", lce_bench.queries_per_update, "Number of "
+               "random queries after each update (default=10).");
+  cp.add_flag("batch", lce_bench.batch, "Answer the (unbounded) queries "
+              "with lce_batch, which prefetches a group of queries at once "
+              "(default: one lce call after the other).");
   cp.add_uint("from", lce_bench.lce_from, "Use only lce "
               "queries which return at least 2^{from} (optional).");
   cp.add_uint("to", lce_bench.lce_to, "Use only lce queries "
@@ -419,6 +541,13 @@ int32_t main(int argc, char *argv[]) {
     std::exit(EXIT_FAILURE);
   }
 
+  lce_test::huge_page_mode huge_pages;
+  if (!lce_test::parse_huge_page_mode(lce_bench.huge_pages, huge_pages)) {
+    std::cerr << "Unknown huge page mode " << lce_bench.huge_pages << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+  lce_test::set_huge_page_mode(huge_pages);
+
   lce_bench.run();
   return 0;
 }
@@ -13,6 +13,8 @@
 #include <vector>
 #include <fstream>
 
+#include "util/huge_pages.hpp"
+
 std::vector<uint8_t> load_text(std::string const& file_path,
                                size_t const prefix_size=0) {
   std::ifstream stream(file_path.c_str(), std::ios::in | std::ios::binary);
@@ -28,7 +30,13 @@ std::vector<uint8_t> load_text(std::string const& file_path,
     file_size = std::min(prefix_size, file_size);
   }
   stream.seekg(0);
-  std::vector<uint8_t> result(file_size);
+  std::vector<uint8_t> result;
+  result.reserve(file_size);
+  // Back the text with huge pages before it is touched for the first time
+  if (lce_test::global_huge_page_mode() != lce_test::huge_page_mode::off) {
+    lce_test::advise_huge_pages(result.data(), file_size);
+  }
+  result.resize(file_size);
   stream.read(reinterpret_cast<char*>(result.data()), file_size);
   stream.close();
   return result;
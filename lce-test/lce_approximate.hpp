@@ -0,0 +1,151 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "util/lce_backend.hpp"
+
+namespace lce_test {
+
+/* Approximate matching by kangaroo jumps, i.e., exact matches between two
+ * errors are skipped with one LCE query each. All functions are templated on
+ * the LCE data structure, so the queries are not dispatched virtually, and
+ * the independent queries of one step are answered with lce_batch. */
+
+/* Length of the longest common prefix of suffixes i and j of a text of
+ * length text_size with at most k mismatches. */
+template <LceBackend backend_type>
+uint64_t lce_k_mismatch(backend_type const& ds, uint64_t const text_size,
+                        uint64_t const i, uint64_t const j, uint64_t const k) {
+  uint64_t const max_length = text_size - std::max(i, j);
+  uint64_t length = 0;
+  for (uint64_t mismatches = 0; length < max_length; ++mismatches) {
+    length += ds.lce_bounded(i + length, j + length, max_length - length);
+    if (length == max_length || mismatches == k) {
+      break;
+    }
+    ++length;  // Jump over the mismatch
+  }
+  return length;
+}
+
+/* Answers the k-mismatch queries (indices[2q], indices[2q + 1]) and stores
+ * the q-th result in results[q]. The queries advance in lockstep: in each
+ * round, the next jump of all unfinished queries is one lce_batch call. */
+template <LceBackend backend_type>
+void lce_k_mismatch_batch(backend_type const& ds, uint64_t const text_size,
+                          std::span<uint64_t const> const indices,
+                          uint64_t const k, std::span<uint64_t> const results) {
+  std::vector<uint64_t> active(results.size());
+  std::vector<uint64_t> jump_indices;
+  std::vector<uint64_t> jumps;
+  size_t num_active = 0;
+  for (size_t q = 0; q < results.size(); ++q) {
+    results[q] = 0;
+    if (indices[2 * q] != indices[2 * q + 1] &&
+        std::max(indices[2 * q], indices[2 * q + 1]) < text_size) {
+      active[num_active++] = q;
+    } else {
+      results[q] = text_size - std::min(text_size, std::max(indices[2 * q], indices[2 * q + 1]));
+    }
+  }
+
+  for (uint64_t mismatches = 0; num_active > 0; ++mismatches) {
+    jump_indices.resize(2 * num_active);
+    jumps.resize(num_active);
+    for (size_t a = 0; a < num_active; ++a) {
+      uint64_t const q = active[a];
+      jump_indices[2 * a] = indices[2 * q] + results[q];
+      jump_indices[2 * a + 1] = indices[2 * q + 1] + results[q];
+    }
+    lce_batch(ds, jump_indices, jumps);
+
+    size_t still_active = 0;
+    for (size_t a = 0; a < num_active; ++a) {
+      uint64_t const q = active[a];
+      uint64_t const max_length =
+          text_size - std::max(indices[2 * q], indices[2 * q + 1]);
+      results[q] = std::min(results[q] + jumps[a], max_length);
+      if (results[q] < max_length && mismatches < k) {
+        ++results[q];  // Jump over the mismatch
+        if (results[q] < max_length) {
+          active[still_active++] = q;
+        }
+      }
+    }
+    num_active = still_active;
+  }
+}
+
+/* Edit distance of T[a, a + a_length) and T[b, b + b_length) if it is at most
+ * max_edits, and max_edits + 1 otherwise (Landau-Vishkin). For each number
+ * of edits e, the furthest reaching path on each diagonal of the band
+ * [-e, e] is extended by one LCE query; the extensions of all diagonals are
+ * answered with one lce_batch call. */
+template <LceBackend backend_type>
+uint64_t edit_distance_banded(backend_type const& ds, uint64_t const a,
+                              uint64_t const a_length, uint64_t const b,
+                              uint64_t const b_length,
+                              uint64_t const max_edits) {
+  int64_t const target = static_cast<int64_t>(b_length) - static_cast<int64_t>(a_length);
+  if (static_cast<uint64_t>(std::abs(target)) > max_edits) {
+    return max_edits + 1;
+  }
+  // furthest[offset + d] is the furthest row (position in a) on diagonal d,
+  // i.e., the path ends at (row, row + d). kUnreached if there is none.
+  constexpr int64_t kUnreached = std::numeric_limits<int64_t>::min() / 2;
+  int64_t const offset = static_cast<int64_t>(max_edits) + 1;
+  std::vector<int64_t> furthest(2 * offset + 1, kUnreached);
+  std::vector<int64_t> previous(2 * offset + 1, kUnreached);
+  std::vector<int64_t> diagonals;
+  std::vector<uint64_t> slide_indices;
+  std::vector<uint64_t> slides;
+  int64_t const rows = a_length;
+
+  for (int64_t e = 0; e <= static_cast<int64_t>(max_edits); ++e) {
+    std::swap(furthest, previous);
+    diagonals.clear();
+    slide_indices.clear();
+    for (int64_t d = -e; d <= e; ++d) {
+      int64_t row;
+      if (e == 0) {
+        row = 0;
+      } else {
+        row = std::max({previous[offset + d] + 1,       // substitution
+                        previous[offset + d - 1],       // insertion
+                        previous[offset + d + 1] + 1}); // deletion
+        row = std::min({row, rows, static_cast<int64_t>(b_length) - d});
+      }
+      // The path must stay inside the dynamic programming matrix
+      if (row < 0 || row + d < 0 || row < std::max<int64_t>(0, -d)) {
+        furthest[offset + d] = kUnreached;
+        continue;
+      }
+      furthest[offset + d] = row;
+      if (row < rows && row + d < static_cast<int64_t>(b_length)) {
+        diagonals.push_back(d);
+        slide_indices.push_back(a + row);
+        slide_indices.push_back(b + row + d);
+      }
+    }
+
+    slides.resize(diagonals.size());
+    lce_batch(ds, slide_indices, slides);
+    for (size_t s = 0; s < diagonals.size(); ++s) {
+      int64_t const d = diagonals[s];
+      int64_t const row = furthest[offset + d];
+      uint64_t const max_slide = std::min<uint64_t>(rows - row, b_length - (row + d));
+      furthest[offset + d] = row + std::min<uint64_t>(slides[s], max_slide);
+    }
+
+    if (std::abs(target) <= e && furthest[offset + target] == rows) {
+      return e;
+    }
+  }
+  return max_edits + 1;
+}
+
+} // namespace lce_test
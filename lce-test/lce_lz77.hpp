@@ -0,0 +1,235 @@
+#pragma once
+
+#include <omp.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include <ips4o.hpp>
+#include <src/libsais.h>
+
+#include "util/lce_backend.hpp"
+#include "util/memory_report.hpp"
+#include "util/phase_profiler.hpp"
+
+namespace lce_test {
+
+/* LZ77 phrase: a copy of length symbols starting at text position source
+ * (which may overlap the phrase), or the literal character source if length
+ * is 0. */
+struct lz77_phrase {
+  uint64_t source;
+  uint64_t length;
+};
+
+/* Approximate LZ77 factorization using LCE queries and the suffix order of a
+ * sample of text positions, e.g., a string synchronizing set, instead of a
+ * full suffix array.
+ *
+ * For a phrase starting at i, let s = i + d be the first sampled position
+ * that is not smaller than i. If T[i..] has a long previous occurrence at
+ * p, then p + d is (in a synchronizing set) sampled, too. Among the sampled
+ * positions smaller than s, the ones with the longest common prefix with s
+ * are its previous and next smaller values in the sampled suffix order, so
+ * the phrase is the longer of the two LCEs lce(i, psv(s) - d) and
+ * lce(i, nsv(s) - d). Hence, each phrase costs a binary search and two LCE
+ * queries.
+ *
+ * The phrases are not always the longest previous factors, so the
+ * factorization is not the greedy one and usually has more phrases (see
+ * lz77_greedy_num_phrases): a previous occurrence is only found if it is
+ * anchored at a sampled position, and only if it also matches the d
+ * characters before s for psv(s) or nsv(s), whereas a sampled position with
+ * a shorter LCE might match them. Otherwise, a literal (or a shorter phrase)
+ * is emitted. */
+template <LceBackend backend_type>
+class LceApproximateLz77Factorizer {
+public:
+  /* Sorts the sample (text positions in increasing order) by suffix using
+     the LCE data structure. The sample is indexed with 32 bits, so it must
+     have less than 2^32 - 1 positions. */
+  LceApproximateLz77Factorizer(backend_type const& ds, uint64_t const text_size,
+                               std::vector<uint64_t> sample)
+      : ds_(&ds), text_size_(text_size), sample_(std::move(sample)) {
+    if (sample_.size() >= kNone) {
+      throw std::length_error("LZ77 sample too large for 32-bit indices");
+    }
+    profiler_.start("sample_sort");
+    std::vector<uint32_t> order(sample_.size());
+    std::iota(order.begin(), order.end(), uint32_t{0});
+    suffix_comparator<backend_type const> const less(ds, text_size_);
+    ips4o::parallel::sort(order.begin(), order.end(),
+                          [&](uint32_t const a, uint32_t const b) {
+                            return less(sample_[a], sample_[b]);
+                          });
+
+    // Previous and next smaller values (by text position) in suffix order.
+    profiler_.start("psv_nsv");
+    psv_.resize(sample_.size());
+    nsv_.resize(sample_.size());
+    std::vector<uint32_t> stack;
+    for (uint32_t const a : order) {
+      while (!stack.empty() && stack.back() > a) {
+        stack.pop_back();
+      }
+      psv_[a] = stack.empty() ? kNone : stack.back();
+      stack.push_back(a);
+    }
+    stack.clear();
+    for (auto it = order.rbegin(); it != order.rend(); ++it) {
+      while (!stack.empty() && stack.back() > *it) {
+        stack.pop_back();
+      }
+      nsv_[*it] = stack.empty() ? kNone : stack.back();
+      stack.push_back(*it);
+    }
+    profiler_.stop();
+  }
+
+  /* Longest phrase starting at i that is found using the sample, i.e., a
+     lower bound of the longest previous factor (see above). */
+  lz77_phrase anchored_phrase_at(uint64_t const i) const {
+    lz77_phrase phrase{static_cast<uint8_t>((*ds_)[i]), 0};
+    auto const next = std::lower_bound(sample_.begin(), sample_.end(), i);
+    if (next == sample_.end()) {
+      return phrase;
+    }
+    uint32_t const a = next - sample_.begin();
+    uint64_t const d = *next - i;
+    for (uint32_t const candidate : {psv_[a], nsv_[a]}) {
+      if (candidate == kNone || sample_[candidate] < d ||
+          sample_[candidate] >= *next) {
+        continue;
+      }
+      uint64_t const source = sample_[candidate] - d;
+      uint64_t const length = ds_->lce_bounded(i, source, text_size_ - i);
+      if (length > phrase.length) {
+        phrase = {source, length};
+      }
+    }
+    return phrase;
+  }
+
+  /* Factorizes the text and passes the phrases in text order to
+     emit(phrases), where phrases is a span of lz77_phrase. The text is split
+     into blocks of block_size, which are factorized in parallel (a phrase
+     never crosses a block boundary, but may refer to any previous position).
+     One round of blocks (one per thread) is buffered at a time. Returns the
+     number of phrases. */
+  template <typename callback_type>
+  uint64_t factorize(callback_type&& emit,
+                     uint64_t const block_size = uint64_t{1} << 22) const {
+    int const num_threads = omp_get_max_threads();
+    std::vector<std::vector<lz77_phrase>> phrases(num_threads);
+    uint64_t num_phrases = 0;
+
+    for (uint64_t round_start = 0; round_start < text_size_;
+         round_start += num_threads * block_size) {
+#pragma omp parallel num_threads(num_threads)
+      {
+        int const t = omp_get_thread_num();
+        uint64_t const block_start = round_start + t * block_size;
+        uint64_t const block_end = std::min(text_size_, block_start + block_size);
+        phrases[t].clear();
+        for (uint64_t i = block_start; i < block_end;) {
+          lz77_phrase phrase = anchored_phrase_at(i);
+          phrase.length = std::min(phrase.length, block_end - i);
+          phrases[t].push_back(phrase);
+          i += std::max<uint64_t>(phrase.length, 1);
+        }
+      }
+      for (auto const& block_phrases : phrases) {
+        if (!block_phrases.empty()) {
+          emit(std::span<lz77_phrase const>(block_phrases));
+          num_phrases += block_phrases.size();
+        }
+      }
+    }
+    return num_phrases;
+  }
+
+  size_t sample_size() const {
+    return sample_.size();
+  }
+
+  lce_test::phase_profiler const& getPhaseProfile() const {
+    return profiler_;
+  }
+
+  /* Space on top of the LCE data structure */
+  memory_report memory_breakdown() const {
+    memory_report report;
+    report.add("sample", bytes_of(sample_));
+    report.add("psv", bytes_of(psv_));
+    report.add("nsv", bytes_of(nsv_));
+    return report;
+  }
+
+private:
+  static constexpr uint32_t kNone = std::numeric_limits<uint32_t>::max();
+
+  backend_type const* ds_;
+  uint64_t const text_size_;
+  std::vector<uint64_t> sample_;
+  std::vector<uint32_t> psv_;
+  std::vector<uint32_t> nsv_;
+  lce_test::phase_profiler profiler_;
+}; // class LceApproximateLz77Factorizer
+
+/* Number of phrases of the greedy LZ77 factorization, in which each phrase is
+ * the longest previous factor (or a literal). It is computed with a full
+ * suffix array, from which the previous and next smaller values are derived
+ * (Kaerkkaeinen, Kempa and Puglisi), and needs 12 bytes per character. This is
+ * a reference for the number of phrases of LceApproximateLz77Factorizer, and
+ * the text must be shorter than 2^31 characters. */
+inline uint64_t lz77_greedy_num_phrases(std::vector<uint8_t> const& text) {
+  if (text.size() > uint64_t{std::numeric_limits<int32_t>::max()}) {
+    throw std::length_error("lz77_greedy_num_phrases: text must be shorter than 2^31");
+  }
+  int32_t const n = text.size();
+  std::vector<int32_t> sa(n);
+  libsais(text.data(), sa.data(), n, 0, nullptr);
+
+  // psv[i] and nsv[i] are the previous and next smaller text positions next
+  // to suffix i in suffix order (or -1)
+  std::vector<int32_t> psv(n);
+  std::vector<int32_t> nsv(n);
+  std::vector<int32_t> stack;
+  for (int32_t const i : sa) {
+    while (!stack.empty() && stack.back() > i) {
+      nsv[stack.back()] = i;
+      stack.pop_back();
+    }
+    psv[i] = stack.empty() ? -1 : stack.back();
+    stack.push_back(i);
+  }
+  for (int32_t const i : stack) {
+    nsv[i] = -1;
+  }
+  sa = std::vector<int32_t>();
+
+  // The scanned characters of all phrases sum up to O(n)
+  uint64_t num_phrases = 0;
+  for (int64_t i = 0; i < n; ++num_phrases) {
+    int64_t length = 0;
+    for (int64_t const source : {int64_t{psv[i]}, int64_t{nsv[i]}}) {
+      if (source < 0) {
+        continue;
+      }
+      int64_t l = 0;
+      while (i + l < n && text[source + l] == text[i + l]) {
+        ++l;
+      }
+      length = std::max(length, l);
+    }
+    i += std::max<int64_t>(length, 1);
+  }
+  return num_phrases;
+}
+
+} // namespace lce_test
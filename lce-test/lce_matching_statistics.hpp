@@ -0,0 +1,222 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <src/libsais64.h>
+
+#include "util/lce_backend.hpp"
+#include "util/memory_report.hpp"
+#include "util/phase_profiler.hpp"
+
+namespace lce_test {
+
+/* Matching statistics of a query with respect to the indexed text: for each
+ * position k of the query, the length of the longest prefix of query[k..]
+ * that occurs in the text, and a text position where it occurs.
+ *
+ * The suffixes of the text are ordered by a suffix array, in which each query
+ * suffix is located by binary search. Because query[k + 1..] shares the first
+ * ms[k] - 1 characters with the text suffix at pos[k] + 1, every comparison
+ * with a text suffix is answered by an LCE query on the text first. Only
+ * characters beyond this known match are compared directly, so long matches
+ * cost O(log n) LCE queries per position instead of scanning the match. */
+template <LceBackend backend_type>
+class LceMatchingStatistics {
+public:
+  struct match {
+    uint64_t length;
+    uint64_t text_pos;
+  };
+
+  /* Builds the suffix array of the text and then the LCE data structure using
+     build(text). If pad_text_to_words is set, the text is padded to a
+     multiple of 8 bytes (required by LcePrezza) after the suffix array has
+     been built. */
+  template <typename builder_type>
+  LceMatchingStatistics(std::vector<uint8_t> text, builder_type&& build,
+                        bool const pad_text_to_words = false)
+      : text_(std::move(text)), text_size_(text_.size()) {
+    profiler_.start("sa_construct");
+    sa_.resize(text_size_);
+    libsais64(text_.data(), reinterpret_cast<int64_t*>(sa_.data()),
+              text_size_, 0, nullptr);
+
+    profiler_.start("lce_construct");
+    if (pad_text_to_words) {
+      text_.resize(text_.size() + (8 - (text_.size() % 8)));
+    }
+    ds_ = build(text_);
+    profiler_.stop();
+  }
+
+  // The data structure may refer to text_, so it must not be moved
+  LceMatchingStatistics(LceMatchingStatistics const&) = delete;
+  LceMatchingStatistics& operator=(LceMatchingStatistics const&) = delete;
+
+  /* Longest prefix of query[k..] that occurs in the text. If it is known that
+     query[k, k + hint_length) occurs at text position hint_pos, the hint is
+     used to answer comparisons with LCE queries. */
+  match longest_match(std::span<uint8_t const> const query, uint64_t const k,
+                      uint64_t const hint_pos = 0,
+                      uint64_t const hint_length = 0) const {
+    uint64_t const query_length = query.size() - k;
+    // Invariant: suffix sa_[lo - 1] < query[k..] <= suffix sa_[hi]
+    uint64_t lo = 0;
+    uint64_t hi = text_size_;
+    match lo_match{0, 0};
+    match hi_match{0, 0};
+
+    while (lo < hi) {
+      uint64_t const mid = lo + (hi - lo) / 2;
+      uint64_t const s = sa_[mid];
+      uint64_t const max_length = std::min(query_length, text_size_ - s);
+      // All suffixes between lo and hi share this prefix with the query
+      uint64_t lce = std::min(lo_match.length, hi_match.length);
+      bool greater;
+
+      uint64_t const text_lce = (hint_length > lce)
+          ? ds_->lce_bounded(hint_pos, s, hint_length) : 0;
+      if (text_lce < hint_length && hint_length > lce) {
+        // The query and the hint differ from suffix s at the same position
+        lce = text_lce;
+        greater = (s + lce == text_size_) ||
+                  char_at(hint_pos + lce) > char_at(s + lce);
+      } else {
+        lce = std::max(lce, text_lce);
+        while (lce < max_length && query[k + lce] == char_at(s + lce)) {
+          ++lce;
+        }
+        greater = (lce < max_length) ? query[k + lce] > char_at(s + lce)
+                                     : lce < query_length;
+      }
+
+      if (greater) {
+        lo = mid + 1;
+        lo_match = {lce, s};
+      } else {
+        hi = mid;
+        hi_match = {lce, s};
+      }
+    }
+    return (lo_match.length > hi_match.length) ? lo_match : hi_match;
+  }
+
+  /* Computes the matching statistics of the query. The query is split into
+     chunks of chunk_size positions, which are processed in parallel. Text
+     positions are only stored if positions is not empty. */
+  void compute(std::span<uint8_t const> const query,
+               std::span<uint64_t> const lengths,
+               std::span<uint64_t> const positions = {},
+               uint64_t const chunk_size = uint64_t{1} << 16) const {
+    uint64_t const num_chunks = (query.size() + chunk_size - 1) / chunk_size;
+
+#pragma omp parallel for schedule(dynamic, 1)
+    for (uint64_t chunk = 0; chunk < num_chunks; ++chunk) {
+      uint64_t const chunk_end = std::min(query.size(), (chunk + 1) * chunk_size);
+      match previous{0, 0};
+      for (uint64_t k = chunk * chunk_size; k < chunk_end; ++k) {
+        previous = (previous.length > 1)
+            ? longest_match(query, k, previous.text_pos + 1, previous.length - 1)
+            : longest_match(query, k);
+        lengths[k] = previous.length;
+        if (!positions.empty()) {
+          positions[k] = previous.text_pos;
+        }
+      }
+    }
+  }
+
+  /* Computes the matching statistics of a query that is read from the stream
+     in blocks of (at least) block_size bytes. After each block, the results
+     are passed to emit(first_pos, lengths, positions) in query order. Matches
+     that reach the end of a block may continue in the next one, so their
+     positions are carried over and recomputed. Returns the query length. */
+  template <typename callback_type>
+  uint64_t stream(std::istream& in, callback_type&& emit,
+                  uint64_t const block_size = uint64_t{1} << 24,
+                  uint64_t const chunk_size = uint64_t{1} << 16) const {
+    std::vector<uint8_t> buffer;
+    std::vector<uint64_t> lengths;
+    std::vector<uint64_t> positions;
+    uint64_t emitted = 0;
+    bool eof = false;
+
+    while (!eof) {
+      // At least doubling the carried part keeps the recomputation linear
+      uint64_t const carried = buffer.size();
+      uint64_t const read_size = std::max(block_size, carried);
+      buffer.resize(carried + read_size);
+      in.read(reinterpret_cast<char*>(buffer.data() + carried), read_size);
+      buffer.resize(carried + in.gcount());
+      eof = !in;
+
+      lengths.resize(buffer.size());
+      positions.resize(buffer.size());
+      compute(buffer, lengths, positions, chunk_size);
+
+      // Since ms[k + 1] >= ms[k] - 1, all matches after the first one that
+      // reaches the end of the block reach it, too.
+      uint64_t done = buffer.size();
+      if (!eof) {
+        while (done > 0 && done - 1 + lengths[done - 1] == buffer.size()) {
+          --done;
+        }
+      }
+      emit(emitted, std::span<uint64_t const>(lengths.data(), done),
+           std::span<uint64_t const>(positions.data(), done));
+      emitted += done;
+      buffer.erase(buffer.begin(), buffer.begin() + done);
+    }
+    return emitted;
+  }
+
+  uint64_t text_size() const {
+    return text_size_;
+  }
+
+  backend_type const& backend() const {
+    return *ds_;
+  }
+
+  lce_test::phase_profiler const& getPhaseProfile() const {
+    return profiler_;
+  }
+
+  uint64_t getSizeInBytes() const {
+    return memory_breakdown().total();
+  }
+
+  /* The text is part of the data structure's report (as its text or, for
+     in-place data structures, its fingerprints). */
+  memory_report memory_breakdown() const {
+    memory_report report = ds_->memory_breakdown();
+    report.add("sa", bytes_of(sa_));
+    return report;
+  }
+
+private:
+  inline uint8_t char_at(uint64_t const i) const {
+    return static_cast<uint8_t>((*ds_)[i]);
+  }
+
+  std::vector<uint8_t> text_;
+  uint64_t const text_size_;
+  std::vector<uint64_t> sa_;
+  std::unique_ptr<backend_type> ds_;
+  lce_test::phase_profiler profiler_;
+}; // class LceMatchingStatistics
+
+/* Deduces the data structure type from the builder. */
+template <typename builder_type>
+LceMatchingStatistics(std::vector<uint8_t>, builder_type&&, bool = false)
+    -> LceMatchingStatistics<typename std::invoke_result_t<
+        builder_type&, std::vector<uint8_t>&>::element_type>;
+
+} // namespace lce_test
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "util/lce_backend.hpp"
+#include "util/memory_report.hpp"
+
+namespace lce_test {
+
+/* LCE queries between the texts of a collection, i.e., lce(a, i, b, j) is the
+ * length of the longest common prefix of suffix i of text a and suffix j of
+ * text b. One LCE data structure (e.g. LceSemiSyncSetsPar or LcePrezza) is
+ * built over the concatenation of all texts. Each query is answered by a
+ * bounded query on the concatenation, capped at the end of both texts, so
+ * matches never extend across text boundaries (and no separator characters
+ * are needed, which would have to be excluded from the alphabet). */
+template <LceBackend backend_type>
+class LceMultiText {
+public:
+  /* Concatenates the texts and builds the data structure using build(text),
+     which is called with the concatenation. The texts are released as soon
+     as they are copied, so the peak memory is the concatenation plus the
+     largest text. If pad_text_to_words is set, the concatenation is padded
+     to a multiple of 8 bytes (required by LcePrezza). */
+  template <typename builder_type>
+  LceMultiText(std::vector<std::vector<uint8_t>> texts, builder_type&& build,
+               bool const pad_text_to_words = false) {
+    offsets_.reserve(texts.size() + 1);
+    offsets_.push_back(0);
+    for (auto const& text : texts) {
+      offsets_.push_back(offsets_.back() + text.size());
+    }
+    text_.reserve(offsets_.back() + 8);
+    for (auto& text : texts) {
+      text_.insert(text_.end(), text.begin(), text.end());
+      std::vector<uint8_t>().swap(text);
+    }
+    if (pad_text_to_words) {
+      text_.resize(text_.size() + (8 - (text_.size() % 8)));
+    }
+    ds_ = build(text_);
+  }
+
+  // The data structure may refer to text_, so it must not be moved
+  LceMultiText(LceMultiText const&) = delete;
+  LceMultiText& operator=(LceMultiText const&) = delete;
+
+  /* Answers the lce query for suffix i of text a and suffix j of text b */
+  inline uint64_t lce(size_t const a, uint64_t const i, size_t const b,
+                      uint64_t const j) const {
+    return ds_->lce_bounded(offsets_[a] + i, offsets_[b] + j,
+                            std::min(text_size(a) - i, text_size(b) - j));
+  }
+
+  /* Returns min(lce(a, i, b, j), cap) */
+  inline uint64_t lce_bounded(size_t const a, uint64_t const i, size_t const b,
+                              uint64_t const j, uint64_t const cap) const {
+    return ds_->lce_bounded(offsets_[a] + i, offsets_[b] + j,
+                            std::min({text_size(a) - i, text_size(b) - j, cap}));
+  }
+
+  /* Returns the character at position i of text a */
+  inline char operator()(size_t const a, uint64_t const i) const {
+    return (*ds_)[offsets_[a] + i];
+  }
+
+  /* Whether suffix i of text a is lexicographically smaller than suffix j
+     of text b */
+  bool isSmallerSuffix(size_t const a, uint64_t const i, size_t const b,
+                       uint64_t const j) const {
+    uint64_t const lce_s = lce(a, i, b, j);
+    // Suffix j of text b is a prefix of suffix i of text a
+    if (j + lce_s == text_size(b)) [[unlikely]] {
+      return false;
+    }
+    if (i + lce_s == text_size(a)) [[unlikely]] {
+      return true;
+    }
+    return static_cast<uint8_t>((*this)(a, i + lce_s)) <
+           static_cast<uint8_t>((*this)(b, j + lce_s));
+  }
+
+  size_t num_texts() const {
+    return offsets_.size() - 1;
+  }
+
+  uint64_t text_size(size_t const a) const {
+    return offsets_[a + 1] - offsets_[a];
+  }
+
+  /* Position of text a in the concatenation */
+  uint64_t offset(size_t const a) const {
+    return offsets_[a];
+  }
+
+  backend_type const& backend() const {
+    return *ds_;
+  }
+
+  uint64_t getSizeInBytes() const {
+    return memory_breakdown().total();
+  }
+
+  /* The concatenation is part of the data structure's report (as its text or,
+     for in-place data structures, its fingerprints). */
+  memory_report memory_breakdown() const {
+    memory_report report = ds_->memory_breakdown();
+    report.add("offsets", bytes_of(offsets_));
+    return report;
+  }
+
+private:
+  std::vector<uint8_t> text_;
+  std::vector<uint64_t> offsets_;
+  std::unique_ptr<backend_type> ds_;
+}; // class LceMultiText
+
+/* Deduces the data structure type from the builder. */
+template <typename builder_type>
+LceMultiText(std::vector<std::vector<uint8_t>>, builder_type&&, bool = false)
+    -> LceMultiText<typename std::invoke_result_t<
+        builder_type&, std::vector<uint8_t>&>::element_type>;
+
+} // namespace lce_test
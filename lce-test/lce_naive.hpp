@@ -8,17 +8,19 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
 #include <vector>
 
 #include <tlx/define/likely.hpp>
 
-#include "util/lce_interface.hpp"
+#include "util/lce_backend.hpp"
+#include "util/naive_lce.hpp"
 
 /* This class stores a text as an array of characters and 
  * answers LCE-queries with the naive method. */
 
-class LceNaive : public LceDataStructure {
+class LceNaive {
 public:
   __extension__ typedef unsigned __int128 uint128_t;
 
@@ -26,52 +28,30 @@ public:
     : text_(text), text_length_in_bytes_(text.size()) { }
 
   /* Naive LCE-query */
-  uint64_t lce(const uint64_t i, const uint64_t j) {
-
+  uint64_t lce(const uint64_t i, const uint64_t j) const {
     if (TLX_UNLIKELY(i == j)) {
       return text_length_in_bytes_ - i;
     }
-
     const uint64_t max_length = text_length_in_bytes_ - ((i < j) ? j : i);
-    uint64_t lce = 0;
-    // First we compare the first few characters. We do this, because in the
-    // usual case the lce is low.
-    for(; lce < 8; ++lce) {
-      if(TLX_UNLIKELY(lce >= max_length)) {
-        return max_length;
-      }
-      if(text_[i + lce] != text_[j + lce]) {
-        return lce;
-      }
-    }
+    return lce_test::naive_lce(text_.data(), i, j, max_length);
+  }
 
-    // Accelerate search by comparing 16-byte blocks
-    lce = 0;
-    uint128_t const* const text_blocks_i =
-      reinterpret_cast<uint128_t const*>(text_.data() + i);
-    uint128_t const * const text_blocks_j =
-      reinterpret_cast<uint128_t const *>(text_.data() + j);
-    for(; lce < max_length/16; ++lce) {
-      if(text_blocks_i[lce] != text_blocks_j[lce]) {
-        break;
-      }
-    }
-    lce *= 16;
-    // The last block did not match. Here we compare its single characters
-    uint64_t lce_end = std::min(lce + 16, max_length);
-    for (; lce < lce_end; ++lce) {
-      if(text_[i + lce] != text_[j + lce]) {
-        break;
-      }
+  /* Returns min(lce(i, j), cap). Only the first cap characters are compared. */
+  uint64_t lce_bounded(const uint64_t i, const uint64_t j,
+                       const uint64_t cap) const {
+    const uint64_t max_length =
+        std::min(cap, text_length_in_bytes_ - ((i < j) ? j : i));
+    if (TLX_UNLIKELY(i == j)) {
+      return max_length;
     }
-    return lce;
+    return lce_test::naive_lce(text_.data(), i, j, max_length);
   }
 
-  inline char operator[](const uint64_t i) {
+  inline char operator[](const uint64_t i) const {
     return text_[i];
   }
 
-  int isSmallerSuffix(const uint64_t i, const uint64_t j) {
+  int isSmallerSuffix(const uint64_t i, const uint64_t j) const {
     uint64_t lce_s = lce(i, j);
     if(TLX_UNLIKELY((i + lce_s + 1 == text_length_in_bytes_) ||
                 (j + lce_s + 1 == text_length_in_bytes_))) {
@@ -80,8 +60,14 @@ public:
     return (text_[i + lce_s] < text_[j + lce_s]);
   }
 
-  uint64_t getSizeInBytes() {
-    return text_length_in_bytes_;
+  uint64_t getSizeInBytes() const {
+    return memory_breakdown().total();
+  }
+
+  lce_test::memory_report memory_breakdown() const {
+    lce_test::memory_report report;
+    report.add("text", text_length_in_bytes_);
+    return report;
   }
 
 private: 
@@ -9,24 +9,25 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
 #include <vector>
 
 #include <tlx/define/likely.hpp>
 
-#include "util/lce_interface.hpp"
+#include "util/lce_backend.hpp"
 
 
 /* This class stores a text as an array of characters and 
  * answers LCE-queries with the naive method. */
 
-class LceUltraNaive : public LceDataStructure {
+class LceUltraNaive {
 public:
   LceUltraNaive(std::vector<uint8_t> const& text)
     : text_(text), text_length_in_bytes_(text.size()) { }
 
   /* Naive LCE-query */
-  uint64_t lce(const uint64_t i, const uint64_t j) {
+  uint64_t lce(const uint64_t i, const uint64_t j) const {
     if (TLX_UNLIKELY(i == j)) {
       return text_length_in_bytes_ - i;
     }
@@ -39,11 +40,26 @@ public:
     return lce;
   }
 		
-  inline char operator[](const uint64_t i) {
+  /* Returns min(lce(i, j), cap). Only the first cap characters are compared. */
+  uint64_t lce_bounded(const uint64_t i, const uint64_t j,
+                       const uint64_t cap) const {
+    const uint64_t max_length =
+        std::min(cap, text_length_in_bytes_ - ((i < j) ? j : i));
+    if (TLX_UNLIKELY(i == j)) {
+      return max_length;
+    }
+    uint64_t lce = 0;
+    while(TLX_LIKELY(lce < max_length) && text_[i + lce] == text_[j + lce]) {
+      lce++;
+    }
+    return lce;
+  }
+
+  inline char operator[](const uint64_t i) const {
     return text_[i];
   }
 		
-  int isSmallerSuffix(const uint64_t i, const uint64_t j) {
+  int isSmallerSuffix(const uint64_t i, const uint64_t j) const {
     uint64_t lce_s = lce(i, j);
     if(TLX_UNLIKELY((i + lce_s + 1 == text_length_in_bytes_) ||
                     (j + lce_s + 1 == text_length_in_bytes_))) {
@@ -52,8 +68,14 @@ public:
     return (text_[i + lce_s] < text_[j + lce_s]);
   }
 		
-  uint64_t getSizeInBytes() {
-    return text_length_in_bytes_;
+  uint64_t getSizeInBytes() const {
+    return memory_breakdown().total();
+  }
+
+  lce_test::memory_report memory_breakdown() const {
+    lce_test::memory_report report;
+    report.add("text", text_length_in_bytes_);
+    return report;
   }
 		
 private:
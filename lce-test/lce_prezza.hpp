@@ -9,96 +9,68 @@
 #pragma once
 
 #include <algorithm>
+#include <span>
 
-#include "util/lce_interface.hpp"
+#include "util/fingerprint_policy.hpp"
+#include "util/lce_backend.hpp"
+#include "util/prezza_blocks.hpp"
 #include "util/util.hpp"
 #include <cmath>
 #include <bit>
 #include <assert.h>
 
 /* This class builds Prezza's in-place LCE data structure and
- * answers LCE-queries in O(log(n)). */
-template <uint64_t t_naive_scan = 128>
-class LcePrezza : public LceDataStructure {
-
-/* Calculates the powers of 2. This supports LCE queries and reduces the time
-     from polylogarithmic to logarithmic. */
-  static constexpr std::array<uint64_t, 70> calculatePowers() {
-    std::array<uint64_t, 70> powers;
-    uint128_t x = 256;
-    powers[0] = static_cast<uint64_t>(x);
-    for (size_t i = 1; i < powers.size(); ++i) {
-      x = (x*x) % prime_;
-      powers[i] = static_cast<uint64_t>(x);
-    }
-    return powers;
-  }
+ * answers LCE-queries in O(log(n)). All queries are const and reentrant, so
+ * one instance can serve many threads (see util/lce_frozen.hpp) as long as
+ * the text is not retransformed meanwhile. The modular arithmetic of the
+ * fingerprints is done by t_fingerprint (see util/fingerprint_policy.hpp). */
+template <uint64_t t_naive_scan = 128,
+          typename t_fingerprint = lce_test::fingerprint_division<>>
+class LcePrezza {
 
 public:
   __extension__ typedef unsigned __int128 uint128_t;
   LcePrezza() = delete;
   /* Loads the full file located at PATH and builds Prezza's LCE data structure */
-  LcePrezza(uint64_t * const text, size_t const size)
+  LcePrezza(uint64_t * const text, size_t const size,
+            t_fingerprint const fingerprint = t_fingerprint())
   : text_length_in_bytes_(size),
     text_length_in_blocks_(size / 8 + (size % 8 == 0 ? 0 : 1)),
-    fingerprints_(text) {
+    fingerprints_(text),
+    fingerprint_(fingerprint),
+    power_table_(lce_test::prezza_powers(fingerprint_)) {
+      // Blocks are restored from their residue and the helping bit
+      assert(fingerprint_.prime() > kHelpingBit);
       calculateFingerprints();
   }
 
 
-  uint64_t lce_scan(const uint64_t i, const uint64_t j, uint64_t max_lce) {
-    uint64_t lce = 0;
-    /* naive part of lce query */
-    /* compare blockwise */
-    const int offset_lce1 = (i % 8) * 8;
-    const int offset_lce2 = (j % 8) * 8;
-    uint64_t block_i = getBlock(i/8);
-    uint64_t block_i2 = getBlockGuaranteeIgeqOne(i/8 + 1);
-    uint64_t block_j = getBlock(j/8);
-    uint64_t block_j2 = getBlockGuaranteeIgeqOne(j/8 + 1);
-    uint64_t comp_block_i = (block_i << offset_lce1) +
-      ((block_i2 >> 1) >> (63-offset_lce1));
-    uint64_t comp_block_j = (block_j << offset_lce2) +
-      ((block_j2 >> 1) >> (63-offset_lce2));
-
-    const uint64_t max_block_naive = max_lce < t_naive_scan ? max_lce/8 : t_naive_scan/8;
-    while(lce < max_block_naive) {
-      if(comp_block_i != comp_block_j) {
-        break;
-      }
-      ++lce;
-      block_i = block_i2;
-      block_i2 = getBlockGuaranteeIgeqOne((i/8)+lce+1);
-      block_j = block_j2;
-      block_j2 = getBlockGuaranteeIgeqOne((j/8)+lce+1);
-      comp_block_i = (block_i << offset_lce1) +
-        ((block_i2 >> 1) >> (63-offset_lce1));
-      comp_block_j = (block_j << offset_lce2) +
-        ((block_j2 >> 1) >> (63-offset_lce2));
-    }
-    lce *= 8;
-    /* If everything except the stub matches, we compare the stub character-wise
-       and return the result */
-    if(lce != t_naive_scan) {
-      uint64_t max_stub = std::min((max_lce - lce), uint64_t{8});
-      return lce + std::min<uint64_t>(((std::countl_zero(comp_block_i ^ comp_block_j)) / 8), max_stub);
-    }
-    return t_naive_scan;
+  uint64_t lce_scan(const uint64_t i, const uint64_t j, uint64_t max_lce) const {
+    return lce_test::prezza_lce_scan<t_naive_scan>(
+        [this](const uint64_t b) { return getBlock(b); },
+        [this](const uint64_t b) { return getBlockGuaranteeIgeqOne(b); },
+        i, j, max_lce);
   }
-  
-  
-  
+
   /* Fast LCE-query in O(log(n)) time */
-  uint64_t lce(const uint64_t i, const uint64_t j) {
+  uint64_t lce(const uint64_t i, const uint64_t j) const {
+    return lce_bounded(i, j, text_length_in_bytes_);
+  }
+
+  /* Returns min(lce(i, j), cap) in O(log(min(lce(i, j), cap))) time. Queries
+     with cap <= t_naive_scan only scan the text. */
+  uint64_t lce_bounded(const uint64_t i, const uint64_t j,
+                       const uint64_t cap) const {
+    const uint64_t max_lce =
+        std::min(cap, text_length_in_bytes_ - ((i < j) ? j : i));
     if (i == j) [[unlikely]] {
-      return text_length_in_bytes_ - i;
+      return max_lce;
     }
-    uint64_t max_lce = text_length_in_bytes_ - ((i < j) ? j : i);
     uint64_t lce = lce_scan(i, j, max_lce);
-    if(lce < t_naive_scan) {
+    if(lce < t_naive_scan || lce == max_lce) {
       return lce;
     }
-    /* exponential search */    
+    /* exponential search, stopping at max_lce */
     uint64_t dist = t_naive_scan * 2;
     int exp = std::countr_zero(dist);
 
@@ -112,7 +84,9 @@ public:
     }
 
     /* binary search , we start it at i2 and j2, because we know that 
-     * up until i2 and j2 everything matched */
+     * up until i2 and j2 everything matched. Blocks exceeding max_lce are
+     * treated as mismatches. Afterwards, less than t_naive_scan characters
+     * remain. */
     --exp;
     dist /= 2;
     uint64_t add = dist;
@@ -120,35 +94,110 @@ public:
     while(dist > t_naive_scan) {
       --exp;
       dist /= 2;
-      if(fingerprintExp(i + add, exp) == fingerprintExp(j + add, exp)) {
+      if(add + dist <= max_lce &&
+         fingerprintExp(i + add, exp) == fingerprintExp(j + add, exp)) {
         add += dist;
       }
     }
-    max_lce -= add;
-    return add + lce_scan_to_end(i + add, j + add, max_lce);
+    return add + lce_scan(i + add, j + add, max_lce - add);
+  }
+
+  /* Answers the queries (indices[2k], indices[2k + 1]) in groups of
+     kBatchSize. The blocks of all queries of a group are prefetched first,
+     so their cache misses overlap. */
+  void lce_batch(std::span<uint64_t const> const indices,
+                 std::span<uint64_t> const results) const {
+    for (size_t first = 0; first < results.size(); first += kBatchSize) {
+      const size_t last = std::min(results.size(), first + kBatchSize);
+      for (size_t k = first; k < last; ++k) {
+        __builtin_prefetch(fingerprints_ + indices[2 * k] / 8);
+        __builtin_prefetch(fingerprints_ + indices[2 * k + 1] / 8);
+      }
+      for (size_t k = first; k < last; ++k) {
+        results[k] = lce(indices[2 * k], indices[2 * k + 1]);
+      }
+    }
+  }
+
+  /* Backward LCE-query in O(log(n)) time, i.e., the length of the longest
+     common suffix of T[0, i] and T[0, j]. The fingerprints of T[i-l+1, i] are
+     derived from the same prefix fingerprints as for forward queries. */
+  uint64_t lce_backward(const uint64_t i, const uint64_t j) const {
+    return lce_backward_bounded(i, j, text_length_in_bytes_);
+  }
+
+  /* Returns min(lce_backward(i, j), cap). */
+  uint64_t lce_backward_bounded(const uint64_t i, const uint64_t j,
+                                const uint64_t cap) const {
+    const uint64_t max_lcs = std::min(cap, ((i < j) ? i : j) + 1);
+    if (i == j) [[unlikely]] {
+      return max_lcs;
+    }
+    uint64_t lcs = lcs_scan(i, j, std::min(max_lcs, t_naive_scan));
+    if(lcs < t_naive_scan || lcs == max_lcs) {
+      return lcs;
+    }
+    /* exponential search, stopping at max_lcs */
+    uint64_t dist = t_naive_scan * 2;
+    int exp = std::countr_zero(dist);
+
+    const uint128_t fingerprint_to_i = fingerprintTo(i);
+    const uint128_t fingerprint_to_j = fingerprintTo(j);
+
+    while (dist <= max_lcs &&
+           fingerprintExpTo(fingerprint_to_i, i, exp) == fingerprintExpTo(fingerprint_to_j, j, exp)) {
+      ++exp;
+      dist *= 2;
+    }
+
+    /* binary search on the blocks ending at i - add and j - add */
+    --exp;
+    dist /= 2;
+    uint64_t add = dist;
+
+    while(dist > t_naive_scan) {
+      --exp;
+      dist /= 2;
+      if(add + dist <= max_lcs &&
+         fingerprintExpTo(fingerprintTo(i - add), i - add, exp) ==
+         fingerprintExpTo(fingerprintTo(j - add), j - add, exp)) {
+        add += dist;
+      }
+    }
+    return add + lcs_scan(i - add, j - add, max_lcs - add);
   }
 
   /* Returns the prime*/
   uint128_t getPrime() const {
-    return prime_;
+    return fingerprint_.prime();
   }
 
   /* Returns the character at index i */ 
-  char operator[] (const uint64_t i) {
+  char operator[] (const uint64_t i) const {
     uint64_t block_number = i / 8;
     uint64_t offset = 7 - (i % 8);
     return (getBlock(block_number)) >> (8*offset) & 0xff;
   }
 
-  int isSmallerSuffix(const uint64_t i, const uint64_t j) {
+  int isSmallerSuffix(const uint64_t i, const uint64_t j) const {
     uint64_t lce_s = lce(i, j);
     if(i + lce_s + 1 == text_length_in_bytes_) [[unlikely]] { return true;}
     if(j + lce_s + 1 == text_length_in_bytes_) [[unlikely]] { return false;}
     return (operator[](i + lce_s) < operator[](j + lce_s));
   }
 
-  uint64_t getSizeInBytes() {
-    return text_length_in_bytes_;
+  uint64_t getSizeInBytes() const {
+    return memory_breakdown().total();
+  }
+
+  /* The fingerprints overwrite the text, so they are the only component
+     besides the (usually empty) list of fingerprints with the highest bit
+     set. */
+  lce_test::memory_report memory_breakdown() const {
+    lce_test::memory_report report;
+    report.add("fingerprints", text_length_in_blocks_ * sizeof(uint64_t));
+    report.add("high_fingerprints", lce_test::bytes_of(high_fingerprints_.blocks()));
+    return report;
   }
 
   void retransform_text() {
@@ -156,89 +205,95 @@ public:
       fingerprints_[i] = getBlockGuaranteeIgeqOne(i);
       fingerprints_[i] = __builtin_bswap64(fingerprints_[i]);
     }
-    fingerprints_[0] &= 0x7FFFFFFFFFFFFFFFULL;
+    fingerprints_[0] = __builtin_bswap64(getBlock(0));
+    high_fingerprints_.clear();
   }
 
 private:
   uint64_t text_length_in_bytes_;
   uint64_t text_length_in_blocks_;
-  static constexpr uint128_t prime_{0x800000000000001d};
+  static constexpr size_t kBatchSize = 16;
 
 
   uint64_t * fingerprints_; //We overwrite the text and store the pointer here;
-  static constexpr std::array<uint64_t, 70> power_table_ = calculatePowers();
-
-  uint64_t lce_scan_to_end(const uint64_t i, const uint64_t j, uint64_t max_lce) {
-    uint64_t lce = 0;
-    /* naive part of lce query */
-    /* compare blockwise */
-    const int offset_lce1 = (i % 8) * 8;
-    const int offset_lce2 = (j % 8) * 8;
-    uint64_t block_i = getBlock(i/8);
-    uint64_t block_i2 = getBlockGuaranteeIgeqOne(i/8 + 1);
-    uint64_t block_j = getBlock(j/8);
-    uint64_t block_j2 = getBlockGuaranteeIgeqOne(j/8 + 1);
-    uint64_t comp_block_i = (block_i << offset_lce1) +
-      ((block_i2 >> 1) >> (63-offset_lce1));
-    uint64_t comp_block_j = (block_j << offset_lce2) +
-      ((block_j2 >> 1) >> (63-offset_lce2));
-
-    while(lce < max_lce) {
-      if(comp_block_i != comp_block_j) {
-        break;
+  t_fingerprint fingerprint_;
+  std::array<uint64_t, 70> power_table_;
+  /* Fingerprints with the highest bit set (see util/prezza_blocks.hpp) */
+  lce_test::prezza_high_fingerprints high_fingerprints_;
+
+  static constexpr uint64_t kHelpingBit = lce_test::prezza_high_fingerprints::kHelpingBit;
+
+  /* Returns the fingerprint of the blocks [0, i] */
+  uint64_t prefixFingerprint(const uint64_t i) const {
+    return high_fingerprints_.fingerprint(fingerprints_[i], i);
+  }
+
+  /* Returns the helping bit of block i, i.e., whether the block is at least
+     the prime */
+  uint64_t helpingBit(const uint64_t i) const {
+    return lce_test::prezza_high_fingerprints::helping_bit(fingerprints_[i]);
+  }
+
+  /* Compares T[.., i] and T[.., j] backwards, 8 characters at a time, and
+     returns min(lcs, max_lcs). Requires max_lcs <= min(i, j) + 1. */
+  uint64_t lcs_scan(const uint64_t i, const uint64_t j, const uint64_t max_lcs) const {
+    uint64_t lcs = 0;
+    while(lcs + 8 <= max_lcs) {
+      const uint64_t diff = getBlockEndingAt(i - lcs) ^ getBlockEndingAt(j - lcs);
+      if(diff != 0) {
+        return lcs + std::countr_zero(diff) / 8;
       }
-      ++lce;
-      block_i = block_i2;
-      block_i2 = getBlockGuaranteeIgeqOne((i/8)+lce+1);
-      block_j = block_j2;
-      block_j2 = getBlockGuaranteeIgeqOne((j/8)+lce+1);
-      comp_block_i = (block_i << offset_lce1) +
-        ((block_i2 >> 1) >> (63-offset_lce1));
-      comp_block_j = (block_j << offset_lce2) +
-        ((block_j2 >> 1) >> (63-offset_lce2));
+      lcs += 8;
+    }
+    while(lcs < max_lcs && operator[](i - lcs) == operator[](j - lcs)) {
+      ++lcs;
     }
-    lce *= 8;
-    /* If everything except the stub matches, we compare the stub character-wise
- *        and return the result */
-   
-      uint64_t max_stub = std::min((max_lce - lce), uint64_t{8});
-      return lce + std::min<uint64_t>(((std::countl_zero(comp_block_i ^ comp_block_j)) / 8), max_stub);
+    return lcs;
   }
 
+  /* Returns the 8 characters T[i-7, i] for i >= 7, T[i] in the lowest byte. */
+  uint64_t getBlockEndingAt(const uint64_t i) const {
+    const uint64_t block = getBlock(i / 8);
+    const int offset = i % 8;
+    if(offset == 7) {
+      return block;
+    }
+    // i >= 8 here, so there is a previous block
+    const uint64_t previous_block = getBlock(i / 8 - 1);
+    return (previous_block << (8 * (offset + 1))) | (block >> (8 * (7 - offset)));
+  }
 
   /* Returns the i'th block. A block contains 8 character. */
   uint64_t getBlock(const uint64_t i) const {
-    uint128_t x = (i != 0) ? fingerprints_[i - 1] & 0x7FFFFFFFFFFFFFFFULL : 0;
+    uint128_t x = (i != 0) ? prefixFingerprint(i - 1) : 0;
     x <<= 64;
-    x %= prime_;
+    x = fingerprint_.reduce(x);
 
-    uint64_t current_fingerprint = fingerprints_[i];
-    uint64_t s_bit = current_fingerprint >> 63;
-    current_fingerprint &= 0x7FFFFFFFFFFFFFFFULL;
+    uint64_t current_fingerprint = prefixFingerprint(i);
+    uint64_t s_bit = helpingBit(i);
 
     uint64_t y = static_cast<uint64_t>(x);
 
     y = y <= current_fingerprint ?
-      current_fingerprint - y : prime_ - (y - current_fingerprint);
-    return y + s_bit*static_cast<uint64_t>(prime_);
+      current_fingerprint - y : fingerprint_.prime() - (y - current_fingerprint);
+    return y + s_bit*static_cast<uint64_t>(fingerprint_.prime());
   }
 
   /* Retruns the i'th block for i > 0. */
   uint64_t getBlockGuaranteeIgeqOne(const uint64_t i) const {
     assert(i >= 1);
-    uint128_t x = fingerprints_[i - 1] & 0x7FFFFFFFFFFFFFFFULL;
+    uint128_t x = prefixFingerprint(i - 1);
     x <<= 64;
-    x %= prime_;
+    x = fingerprint_.reduce(x);
 
-    uint64_t current_fingerprint = fingerprints_[i];
-    uint64_t s_bit = current_fingerprint >> 63;
-    current_fingerprint &= 0x7FFFFFFFFFFFFFFFULL;
+    uint64_t current_fingerprint = prefixFingerprint(i);
+    uint64_t s_bit = helpingBit(i);
 
     uint64_t y = static_cast<uint64_t>(x);
 
     y = y <= current_fingerprint ?
-      current_fingerprint - y : prime_ - (y - current_fingerprint);
-    return y + s_bit*static_cast<uint64_t>(prime_);
+      current_fingerprint - y : fingerprint_.prime() - (y - current_fingerprint);
+    return y + s_bit*static_cast<uint64_t>(fingerprint_.prime());
   }
 
   /* Calculates the fingerprint of T[from, from + 2^exp) when the fingerprint
@@ -247,11 +302,11 @@ private:
                           const uint64_t from, const int exp) const {
     uint128_t fingerprint_to_j = fingerprintTo(from + (1 << exp) - 1);
     fingerprint_to_i *= power_table_[exp];
-    fingerprint_to_i %= prime_;
+    fingerprint_to_i = fingerprint_.reduce(fingerprint_to_i);
 
     return fingerprint_to_j >= fingerprint_to_i ?
       static_cast<uint64_t>(fingerprint_to_j - fingerprint_to_i) :
-      static_cast<uint64_t>(prime_ - (fingerprint_to_i - fingerprint_to_j));
+      static_cast<uint64_t>(fingerprint_.prime() - (fingerprint_to_i - fingerprint_to_j));
   }
 
   /* Calculates the fingerprint of T[from, from + 2^exp) */
@@ -259,11 +314,25 @@ private:
     uint128_t fingerprint_to_i = (from != 0) ? fingerprintTo(from - 1) : 0;
     uint128_t fingerprint_to_j = fingerprintTo(from + (1 << exp) - 1);
     fingerprint_to_i *= power_table_[exp];
-    fingerprint_to_i %= prime_;
+    fingerprint_to_i = fingerprint_.reduce(fingerprint_to_i);
 
     return fingerprint_to_j >= fingerprint_to_i ?
       static_cast<uint64_t>(fingerprint_to_j - fingerprint_to_i) :
-      static_cast<uint64_t>(prime_ - (fingerprint_to_i - fingerprint_to_j));
+      static_cast<uint64_t>(fingerprint_.prime() - (fingerprint_to_i - fingerprint_to_j));
+  }
+
+  /* Calculates the fingerprint of T[end - 2^exp + 1, end] when the
+     fingerprint of T[0, end] is already known */
+  uint64_t fingerprintExpTo(uint128_t fingerprint_to_end,
+                            const uint64_t end, const int exp) const {
+    const uint64_t from = end + 1 - (uint64_t{1} << exp);
+    uint128_t fingerprint_to_from = (from != 0) ? fingerprintTo(from - 1) : 0;
+    fingerprint_to_from *= power_table_[exp];
+    fingerprint_to_from = fingerprint_.reduce(fingerprint_to_from);
+
+    return fingerprint_to_end >= fingerprint_to_from ?
+      static_cast<uint64_t>(fingerprint_to_end - fingerprint_to_from) :
+      static_cast<uint64_t>(fingerprint_.prime() - (fingerprint_to_from - fingerprint_to_end));
   }
 
   /* Calculates the fingerprint of T[0..i] */
@@ -273,25 +342,22 @@ private:
     if(pad == 0) [[unlikely]] {
       // This fingerprints is already saved.
       // We only have to remove the helping bit.
-      return fingerprints_[i/8] & 0x7FFFFFFFFFFFFFFFULL; 
+      return prefixFingerprint(i/8);
     }
     /* Add fingerprint from previous block */
     if (i > 7) [[likely]] {
-      fingerprint = fingerprints_[(i/8) - 1] & 0x7FFFFFFFFFFFFFFFULL;
+      fingerprint = prefixFingerprint((i/8) - 1);
       fingerprint <<= pad;    
       uint64_t y = getBlockGuaranteeIgeqOne(i/8);
       fingerprint += (y >> (64 - pad));
       
     } else {
-      const uint64_t current_fingerprint = fingerprints_[0];
-      const uint64_t s_bit = current_fingerprint >> 63;
-      
-      fingerprint = current_fingerprint & 0x7FFFFFFFFFFFFFFFULL;
-      fingerprint += (s_bit*prime_);
+      fingerprint = prefixFingerprint(0);
+      fingerprint += (helpingBit(0)*fingerprint_.prime());
       fingerprint >>= (64 - pad);
     }
 
-    fingerprint %= prime_;
+    fingerprint = fingerprint_.reduce(fingerprint);
     return static_cast<uint64_t>(fingerprint);
   }
 
@@ -314,14 +380,13 @@ private:
       uint128_t x = previous_fingerprint;
       x <<= 64;
       x += current_block;
-      x = x % prime_;
+      x = fingerprint_.reduce(x);
       previous_fingerprint = static_cast<uint64_t>(x);
 
-      /* Additionally store if block > prime */
-      if(current_block > prime_) {
-        x = x + 0x8000000000000000ULL;
-      }
-      fingerprints_[i] = (uint64_t) x;
+      /* The highest bit of fingerprints in [2^63, prime) is stored
+         separately, and the helping bit tells if block >= prime */
+      fingerprints_[i] = high_fingerprints_.encode(static_cast<uint64_t>(x), current_block,
+                                                   fingerprint_.prime(), i);
     }
   }
 };
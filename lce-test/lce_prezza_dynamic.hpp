@@ -0,0 +1,404 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <assert.h>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+#include "util/fingerprint_policy.hpp"
+#include "util/lce_backend.hpp"
+#include "util/memory_report.hpp"
+#include "util/prezza_blocks.hpp"
+
+/* Variant of Prezza's in-place LCE data structure (see lce_prezza.hpp) that
+ * supports point edits update(i, c). The text is divided into superblocks of
+ * t_superblock_blocks blocks (8 characters each). As in LcePrezza, each block
+ * is overwritten with a fingerprint (see util/prezza_blocks.hpp), but only of
+ * the blocks from the start of its superblock, so an edit only invalidates the
+ * rest of its superblock. The fingerprints of the superblocks are kept in a
+ * Fenwick tree. The modular arithmetic is done by t_fingerprint (see
+ * util/fingerprint_policy.hpp).
+ *
+ * update(i, c) takes O(t_superblock_blocks + log(n)) time (plus the size of
+ * the usually empty list of fingerprints with the highest bit set). An LCE
+ * query of length l compares O(log(l)) fingerprints, each in O(1) time if it
+ * does not cross a superblock boundary. Otherwise, it also needs the
+ * fingerprint of all superblocks before, i.e., a Fenwick query in
+ * O(log(n / S)) time, where S = 8 t_superblock_blocks. These are cached per
+ * query, and the search only visits O(1 + log(l / S)) superblocks, so a query
+ * takes O(log(l) + log(l / S) log(n / S)) time: O(log(n)) for LCEs of up to a
+ * few superblocks, but O(log^2(n)) in the worst case. The search compares
+ * prefixes of two unaligned suffixes, and with O(log(n)) time updates each
+ * prefix query already needs Omega(log(n) / log(log(n))) time (Patrascu and
+ * Demaine), so a better bound would need a different search.
+ *
+ * The extra space are n / S words for the Fenwick tree. Queries are const,
+ * but must not run concurrently with update. */
+template <uint64_t t_naive_scan = 128, uint64_t t_superblock_blocks = 64,
+          typename t_fingerprint = lce_test::fingerprint_division<>>
+class LcePrezzaDynamic {
+  static_assert(std::has_single_bit(t_superblock_blocks),
+                "The superblock size must be a power of two");
+
+public:
+  __extension__ typedef unsigned __int128 uint128_t;
+
+private:
+  static constexpr uint64_t kSuperblockChars = 8 * t_superblock_blocks;
+  /* 256^(kSuperblockChars * 2^k) = power_table_[kSuperblockExp + k] */
+  static constexpr int kSuperblockExp = std::countr_zero(kSuperblockChars);
+
+  /* char_power_table_[k] = 256^k for the offsets inside a superblock */
+  static std::array<uint64_t, kSuperblockChars + 1> calculateCharPowers(
+      t_fingerprint const& fingerprint) {
+    std::array<uint64_t, kSuperblockChars + 1> powers;
+    uint128_t x = 1;
+    for (size_t i = 0; i < powers.size(); ++i) {
+      powers[i] = static_cast<uint64_t>(x);
+      x = fingerprint.reduce(x * 256);
+    }
+    return powers;
+  }
+
+  /* The fingerprint of T[0..i] is the fingerprint of the superblocks before
+     i, shifted by offset characters, plus the local fingerprint of the offset
+     characters of i's superblock. The first part is only computed when two of
+     them are in different superblocks. */
+  struct prefix {
+    uint64_t superblock;
+    uint64_t offset;
+    uint64_t local;
+  };
+
+  /* The fingerprints of the superblock prefixes computed by one query */
+  struct prefix_cache {
+    static constexpr size_t kSize = 4;
+    std::array<uint64_t, kSize> superblocks{~uint64_t{0}, ~uint64_t{0}, ~uint64_t{0}, ~uint64_t{0}};
+    std::array<uint64_t, kSize> fingerprints{};
+    size_t next = 0;
+  };
+
+public:
+  LcePrezzaDynamic() = delete;
+  /* Builds the data structure in place of the text, which must be padded to
+     a multiple of 8 characters (as for LcePrezza) */
+  LcePrezzaDynamic(uint64_t * const text, size_t const size,
+                   t_fingerprint const fingerprint = t_fingerprint())
+  : text_length_in_bytes_(size),
+    text_length_in_blocks_(size / 8 + (size % 8 == 0 ? 0 : 1)),
+    fingerprints_(text),
+    fingerprint_(fingerprint),
+    power_table_(lce_test::prezza_powers(fingerprint_)),
+    char_power_table_(calculateCharPowers(fingerprint_)),
+    fenwick_(text_length_in_blocks_ / t_superblock_blocks + 1, 0) {
+      // Blocks are restored from their residue and the helping bit
+      assert(fingerprint_.prime() > lce_test::prezza_high_fingerprints::kHelpingBit);
+      calculateFingerprints();
+  }
+
+  /* Replaces T[i] with c */
+  void update(const uint64_t i, const char c) {
+    const uint64_t block_number = i / 8;
+    const uint64_t superblock = block_number / t_superblock_blocks;
+    const uint64_t superblock_begin = superblock * t_superblock_blocks;
+    const uint64_t superblock_end =
+        std::min(superblock_begin + t_superblock_blocks, text_length_in_blocks_);
+
+    std::array<uint64_t, t_superblock_blocks> blocks;
+    for (uint64_t b = block_number; b < superblock_end; ++b) {
+      blocks[b - superblock_begin] = getBlock(b);
+    }
+    const uint64_t old_fingerprint = localPrefix(superblock_end - 1);
+
+    const int shift = 8 * (7 - (i % 8));
+    uint64_t& block = blocks[block_number - superblock_begin];
+    block = (block & ~(uint64_t{0xff} << shift)) |
+            (uint64_t{static_cast<uint8_t>(c)} << shift);
+
+    uint64_t previous_fingerprint = (block_number != superblock_begin) ?
+      localPrefix(block_number - 1) : 0;
+    for (uint64_t b = block_number; b < superblock_end; ++b) {
+      previous_fingerprint = encodeBlock(previous_fingerprint, blocks[b - superblock_begin], b);
+    }
+
+    // The last superblock may be incomplete and is not in the Fenwick tree
+    if (superblock + 1 < fenwick_.size()) {
+      fenwickAdd(superblock + 1, submod(previous_fingerprint, old_fingerprint));
+    }
+  }
+
+  /* Fast LCE-query, see above for the time */
+  uint64_t lce(const uint64_t i, const uint64_t j) const {
+    return lce_bounded(i, j, text_length_in_bytes_);
+  }
+
+  /* Returns min(lce(i, j), cap). Queries with cap <= t_naive_scan only scan
+     the text. */
+  uint64_t lce_bounded(const uint64_t i, const uint64_t j,
+                       const uint64_t cap) const {
+    const uint64_t max_lce =
+        std::min(cap, text_length_in_bytes_ - ((i < j) ? j : i));
+    if (i == j) [[unlikely]] {
+      return max_lce;
+    }
+    uint64_t lce = lce_scan(i, j, max_lce);
+    if(lce < t_naive_scan || lce == max_lce) {
+      return lce;
+    }
+    prefix_cache cache_i;
+    prefix_cache cache_j;
+
+    /* exponential search, stopping at max_lce. T[i, i + add) = T[j, j + add),
+       and to_i and to_j are the prefixes up to there, so each step only needs
+       the prefixes at its end. */
+    uint64_t add = t_naive_scan;
+    int exp = std::countr_zero(add);
+    prefix to_i = prefixTo(i + add - 1);
+    prefix to_j = prefixTo(j + add - 1);
+    while (2 * add <= max_lce) {
+      const prefix end_i = prefixTo(i + 2 * add - 1);
+      const prefix end_j = prefixTo(j + 2 * add - 1);
+      if (fingerprintExp(to_i, end_i, exp, cache_i) != fingerprintExp(to_j, end_j, exp, cache_j)) {
+        break;
+      }
+      to_i = end_i;
+      to_j = end_j;
+      add *= 2;
+      ++exp;
+    }
+
+    /* binary search on T[i + add, i + 2 add). Blocks exceeding max_lce are
+       treated as mismatches. Afterwards, less than t_naive_scan characters
+       remain. */
+    uint64_t dist = add;
+    while(dist > t_naive_scan) {
+      --exp;
+      dist /= 2;
+      if(add + dist <= max_lce) {
+        const prefix end_i = prefixTo(i + add + dist - 1);
+        const prefix end_j = prefixTo(j + add + dist - 1);
+        if (fingerprintExp(to_i, end_i, exp, cache_i) == fingerprintExp(to_j, end_j, exp, cache_j)) {
+          to_i = end_i;
+          to_j = end_j;
+          add += dist;
+        }
+      }
+    }
+    return add + lce_scan(i + add, j + add, max_lce - add);
+  }
+  /* Returns the character at index i */
+  char operator[] (const uint64_t i) const {
+    uint64_t block_number = i / 8;
+    uint64_t offset = 7 - (i % 8);
+    return (getBlock(block_number)) >> (8*offset) & 0xff;
+  }
+
+  int isSmallerSuffix(const uint64_t i, const uint64_t j) const {
+    uint64_t lce_s = lce(i, j);
+    if(i + lce_s + 1 == text_length_in_bytes_) [[unlikely]] { return true;}
+    if(j + lce_s + 1 == text_length_in_bytes_) [[unlikely]] { return false;}
+    return (operator[](i + lce_s) < operator[](j + lce_s));
+  }
+
+  uint64_t getSizeInBytes() const {
+    return memory_breakdown().total();
+  }
+
+  lce_test::memory_report memory_breakdown() const {
+    lce_test::memory_report report;
+    report.add("fingerprints", text_length_in_blocks_ * sizeof(uint64_t));
+    report.add("fenwick_tree", lce_test::bytes_of(fenwick_));
+    report.add("high_fingerprints", lce_test::bytes_of(high_fingerprints_.blocks()));
+    return report;
+  }
+
+  /* Restores the (edited) text in place of the fingerprints */
+  void retransform_text() {
+    for(size_t i{text_length_in_blocks_}; i > 0; --i) {
+      fingerprints_[i - 1] = getBlock(i - 1);
+    }
+    high_fingerprints_.clear();
+    if constexpr (std::endian::native == std::endian::little) {
+      for(size_t i = 0; i < text_length_in_blocks_; ++i) {
+        fingerprints_[i] = __builtin_bswap64(fingerprints_[i]);
+      }
+    }
+  }
+
+private:
+  uint64_t text_length_in_bytes_;
+  uint64_t text_length_in_blocks_;
+
+  uint64_t * fingerprints_; //We overwrite the text and store the pointer here;
+  t_fingerprint fingerprint_;
+  std::array<uint64_t, 70> power_table_;
+  std::array<uint64_t, kSuperblockChars + 1> char_power_table_;
+  /* fenwick_[k] is the fingerprint of the superblocks (k - lowbit(k), k]
+     (1-based). Only complete superblocks are stored. */
+  std::vector<uint64_t> fenwick_;
+  /* Fingerprints with the highest bit set (see util/prezza_blocks.hpp) */
+  lce_test::prezza_high_fingerprints high_fingerprints_;
+
+  uint64_t mulmod(const uint64_t a, const uint64_t b) const {
+    return fingerprint_.reduce(uint128_t{a} * b);
+  }
+
+  uint64_t addmod(const uint64_t a, const uint64_t b) const {
+    return fingerprint_.reduce(uint128_t{a} + b);
+  }
+
+  uint64_t submod(const uint64_t a, const uint64_t b) const {
+    return a >= b ? a - b : fingerprint_.prime() - (b - a);
+  }
+
+  uint64_t lce_scan(const uint64_t i, const uint64_t j, uint64_t max_lce) const {
+    auto const get_block = [this](const uint64_t b) { return getBlock(b); };
+    return lce_test::prezza_lce_scan<t_naive_scan>(get_block, get_block, i, j, max_lce);
+  }
+
+  /* Returns the fingerprint of the blocks from the start of i's superblock
+     to i */
+  uint64_t localPrefix(const uint64_t i) const {
+    return high_fingerprints_.fingerprint(fingerprints_[i], i);
+  }
+
+  /* Returns the i'th block (0 beyond the end of the text). Its fingerprint
+     is relative to the start of its superblock. */
+  uint64_t getBlock(const uint64_t i) const {
+    if (i >= text_length_in_blocks_) [[unlikely]] {
+      return 0;
+    }
+    uint128_t x = (i % t_superblock_blocks != 0) ? localPrefix(i - 1) : 0;
+    x <<= 64;
+    const uint64_t y = fingerprint_.reduce(x);
+    const uint64_t s_bit = lce_test::prezza_high_fingerprints::helping_bit(fingerprints_[i]);
+    return submod(localPrefix(i), y) + s_bit * fingerprint_.prime();
+  }
+
+  /* Stores the fingerprint of block b, i.e., of block appended to
+     previous_fingerprint, in place of the block and returns it */
+  uint64_t encodeBlock(const uint64_t previous_fingerprint,
+                       const uint64_t block, const uint64_t b) {
+    uint128_t x = previous_fingerprint;
+    x <<= 64;
+    x += block;
+    const uint64_t fingerprint = fingerprint_.reduce(x);
+    fingerprints_[b] = high_fingerprints_.encode(fingerprint, block, fingerprint_.prime(), b);
+    return fingerprint;
+  }
+
+  /* Calculates the fingerprint of T[8 t_superblock_blocks s, i], where s is
+     the superblock of i */
+  uint64_t localFingerprintTo(const uint64_t i) const {
+    const uint64_t block_number = i / 8;
+    int pad = ((i+1) & 7) * 8;
+    if(pad == 0) {
+      return localPrefix(block_number);
+    }
+    uint128_t fingerprint = (block_number % t_superblock_blocks != 0) ?
+      localPrefix(block_number - 1) : 0;
+    fingerprint <<= pad;
+    fingerprint += (getBlock(block_number) >> (64 - pad));
+    return fingerprint_.reduce(fingerprint);
+  }
+
+  /* Splits T[0..i] into its superblock prefix and local part */
+  prefix prefixTo(const uint64_t i) const {
+    const uint64_t superblock = i / kSuperblockChars;
+    return prefix{superblock, i + 1 - superblock * kSuperblockChars, localFingerprintTo(i)};
+  }
+
+  /* Calculates the fingerprint of T[0..i] for the prefix p of T[0..i] */
+  uint64_t fingerprintTo(prefix const& p, prefix_cache& cache) const {
+    if (p.superblock == 0) {
+      return p.local;
+    }
+    return addmod(mulmod(superblockPrefix(p.superblock, cache), char_power_table_[p.offset]),
+                  p.local);
+  }
+
+  /* Calculates the fingerprint of T[from + 1, end] of length 2^exp, where from
+     and end are the prefixes up to from and end. Inside a superblock, the
+     fingerprints of the superblocks before cancel out. */
+  uint64_t fingerprintExp(prefix const& from, prefix const& end, const int exp,
+                          prefix_cache& cache) const {
+    uint64_t fingerprint_to_from;
+    uint64_t fingerprint_to_end;
+    if (from.superblock == end.superblock) {
+      fingerprint_to_from = from.local;
+      fingerprint_to_end = end.local;
+    } else {
+      fingerprint_to_from = fingerprintTo(from, cache);
+      fingerprint_to_end = fingerprintTo(end, cache);
+    }
+    return submod(fingerprint_to_end, mulmod(fingerprint_to_from, power_table_[exp]));
+  }
+
+  /* Fingerprint of the first s superblocks, looked up in cache first */
+  uint64_t superblockPrefix(const uint64_t s, prefix_cache& cache) const {
+    for (size_t k = 0; k < prefix_cache::kSize; ++k) {
+      if (cache.superblocks[k] == s) {
+        return cache.fingerprints[k];
+      }
+    }
+    const uint64_t fingerprint = fenwickPrefix(s);
+    cache.superblocks[cache.next] = s;
+    cache.fingerprints[cache.next] = fingerprint;
+    cache.next = (cache.next + 1) % prefix_cache::kSize;
+    return fingerprint;
+  }
+  /* Fingerprint of the first s superblocks. The nodes are visited from right
+     to left, so each one is shifted by the superblocks visited before. */
+  uint64_t fenwickPrefix(uint64_t s) const {
+    uint64_t fingerprint = 0;
+    uint64_t shift = 1;
+    while (s > 0) {
+      fingerprint = addmod(mulmod(fenwick_[s], shift), fingerprint);
+      shift = mulmod(shift, power_table_[kSuperblockExp + std::countr_zero(s)]);
+      s &= s - 1;
+    }
+    return fingerprint;
+  }
+
+  /* Adds delta to the fingerprint of superblock s (1-based). Every node
+     containing s is followed by lowbit(k) more superblocks than the previous
+     one. */
+  void fenwickAdd(uint64_t s, uint64_t delta) {
+    while (s < fenwick_.size()) {
+      fenwick_[s] = addmod(fenwick_[s], delta);
+      delta = mulmod(delta, power_table_[kSuperblockExp + std::countr_zero(s)]);
+      s += s & (~s + 1);
+    }
+  }
+
+  /* Overwrites each block with the fingerprint of the blocks from the start of
+     its superblock, and builds the Fenwick tree of the complete superblocks
+     in linear time. */
+  void calculateFingerprints() {
+    if constexpr (std::endian::native == std::endian::little) {
+      for(size_t i = 0; i < text_length_in_blocks_; ++i) {
+        fingerprints_[i] = __builtin_bswap64(fingerprints_[i]); //C++23 std::byteswap!
+      }
+    }
+    uint64_t previous_fingerprint = 0;
+    for (uint64_t i = 0; i < text_length_in_blocks_; ++i) {
+      if (i % t_superblock_blocks == 0) {
+        previous_fingerprint = 0;
+      }
+      previous_fingerprint = encodeBlock(previous_fingerprint, fingerprints_[i], i);
+    }
+
+    for (uint64_t s = 1; s < fenwick_.size(); ++s) {
+      fenwick_[s] = localPrefix(s * t_superblock_blocks - 1);
+    }
+    for (uint64_t s = 1; s < fenwick_.size(); ++s) {
+      const uint64_t parent = s + (s & (~s + 1));
+      if (parent < fenwick_.size()) {
+        fenwick_[parent] = addmod(fenwick_[parent],
+          mulmod(fenwick_[s], power_table_[kSuperblockExp + std::countr_zero(s)]));
+      }
+    }
+  }
+};
@@ -34,6 +34,9 @@
  * O(log n) time any two text suffixes (useful for suffix-sorting in-place any
  * subset of text positions)
  *
+ *  All queries are const and reentrant, i.e., one instance can be queried by
+ * multiple threads concurrently.
+ *
  *  Note: there is a probability of getting a wrong LCP result due to hash
  * collisions. however, this probability is less than 2^-120 for real-case texts
  *
@@ -49,12 +52,12 @@
 
 #include "util/prezza_mersenne/rk_lce_bin.hpp"
 #include "util/prezza_mersenne/includes.hpp"
-#include "util/lce_interface.hpp"
+#include "util/lce_backend.hpp"
 #include "util/util.hpp"
 
 namespace rklce {
 
-  class LcePrezzaMersenne : public LceDataStructure {
+  class LcePrezzaMersenne {
 
   public:
     // block size
@@ -106,26 +109,10 @@ namespace rklce {
         // first block of the binary text_ is different than q and
         // the binary text_ size is a multiple of w
         pad = w - (n_ * log2_sigma) % w;
-        // init binary text_ with the padding of zeros
-        auto binary_text = vector<bool>(pad, false);
-
-        // push back binary encoding of input text
-        {
-
-          for (uint64_t i = 0; i < n_; ++i) {
 
-            // char encoding
-            auto bc = char_to_uint[text_[i]];
-
-            for (int j = 0; j < log2_sigma; ++j) {
-
-              bool b = (bc >> (log2_sigma - j - 1)) & uint8_t(1);
-              binary_text.push_back(b);
-            }
-          }
-        }
-        // build LCE structure of the binary text
-        bin_lce = rk_lce_bin(binary_text);
+        // build LCE structure of the binary encoding of the text, which is
+        // packed into blocks directly
+        bin_lce = rk_lce_bin(text_, n_, char_to_uint, log2_sigma, pad);
       }
 
     /*
@@ -134,7 +121,7 @@ namespace rklce {
      * complexity: O(1)
      *
      */
-    inline char operator[](uint64_t i) {
+    inline char operator[](uint64_t i) const {
 
       auto ib = i * log2_sigma + pad;
 
@@ -158,7 +145,7 @@ namespace rklce {
      * - O(log n) otherwise
      *
      */
-    inline uint64_t lce(uint64_t i, uint64_t j) {
+    inline uint64_t lce(uint64_t i, uint64_t j) const {
 
       auto ib = i * log2_sigma + pad;
       auto jb = j * log2_sigma + pad;
@@ -166,10 +153,26 @@ namespace rklce {
       return bin_lce.LCE(ib, jb) / log2_sigma;
     }
 
+    /*
+     * min(LCE, cap) between i-th and j-th suffixes
+     *
+     * complexity: O(1) if cap * log2_sigma is shorter than T.block_size(),
+     * O(log cap) otherwise
+     *
+     */
+    inline uint64_t lce_bounded(uint64_t i, uint64_t j, uint64_t cap) const {
+
+      auto ib = i * log2_sigma + pad;
+      auto jb = j * log2_sigma + pad;
+      cap = std::min(cap, n_);
+
+      return bin_lce.LCE(ib, jb, cap * log2_sigma) / log2_sigma;
+    }
+
     /*
      * O(n)-time implementation of LCE
      */
-    inline uint64_t LCE_naive(uint64_t i, uint64_t j) {
+    inline uint64_t LCE_naive(uint64_t i, uint64_t j) const {
 
       if (i == j)
         return n_ - i;
@@ -191,35 +194,37 @@ namespace rklce {
      * Time: O(log n)
      *
      */
-    inline std::function<bool(uint64_t, uint64_t)> lex_less_than() {
+    inline std::function<bool(uint64_t, uint64_t)> lex_less_than() const {
 
-      return [&](uint64_t i, uint64_t j) {
-               if (i == j)
-                 return false;
+      return [this](uint64_t i, uint64_t j) {
+               return isSmallerSuffix(i, j);
+             };
+    }
 
-               // rightmost suffix is the shortest
-               uint64_t min = i < j ? j : i;
+    /*
+     * true iif i-th suffix is < than j-th suffix (see lex_less_than)
+     */
+    inline int isSmallerSuffix(const uint64_t i, const uint64_t j) const {
+      if (i == j)
+        return false;
 
-               auto v_lce = lce(i, j);
+      // rightmost suffix is the shortest
+      uint64_t min = i < j ? j : i;
 
-               // in this case shortest suffix is the smallest
-               if (v_lce == n_ - min)
-                 return i == min;
+      auto v_lce = lce(i, j);
 
-               assert(i + v_lce < n_);
-               assert(j + v_lce < n_);
+      // in this case shortest suffix is the smallest
+      if (v_lce == n_ - min)
+        return i == min;
 
-               // get characters following LCE
-               auto ic = operator[](i + v_lce);
-               auto jc = operator[](j + v_lce);
+      assert(i + v_lce < n_);
+      assert(j + v_lce < n_);
 
-               return ic < jc;
-             };
-    }
-  
-    inline int isSmallerSuffix([[maybe_unused]] const uint64_t i,
-                               [[maybe_unused]] const uint64_t j) {
-      return true;
+      // get characters following LCE
+      auto ic = operator[](i + v_lce);
+      auto jc = operator[](j + v_lce);
+
+      return ic < jc;
     }
 
     inline uint64_t bit_size() {
@@ -228,15 +233,28 @@ namespace rklce {
         uint_to_char.size() * 8;
     }
 
-    inline uint64_t length() {
+    inline uint64_t length() const {
       return n_;
     }
-    inline uint64_t size() {
+    inline uint64_t size() const {
       return n_;
     }
   
-    inline uint64_t getSizeInBytes() {
-      return n_;
+    inline uint64_t getSizeInBytes() const {
+      return memory_breakdown().total();
+    }
+
+    /*
+     * The binary text is only stored as prefix fingerprints, so the input
+     * text is not part of the data structure.
+     */
+    inline lce_test::memory_report memory_breakdown() const {
+      lce_test::memory_report report;
+      report.add("alphabet_map", lce_test::bytes_of(char_to_uint) +
+                 lce_test::bytes_of(uint_to_char));
+      report.add("fingerprints", bin_lce.size_in_bytes_P());
+      report.add("full_blocks", bin_lce.size_in_bytes_Q());
+      return report;
     }
 
     inline uint16_t alphabet_size() {
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <omp.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "util/lce_backend.hpp"
+
+namespace lce_test {
+
+/* Maximal repetition T[start, start + length) with smallest period period
+ * and length >= 2 * period. */
+struct text_run {
+  uint64_t start;
+  uint64_t length;
+  uint64_t period;
+};
+
+/* Computes all runs of a text of length text_size with a period in
+ * [min_period, max_period] using forward and backward LCE queries.
+ *
+ * A run with period p contains two consecutive multiples i and i + p of p.
+ * Hence, for each p, we extend the squares at all multiples i of p: with
+ * f = lce(i, i + p) and b = lce_backward(i - 1, i + p - 1), there is a
+ * repetition T[i - b, i + p + f) with period p if b + f >= p. It is reported
+ * only at the first multiple of p inside it (b < p), and only if p is its
+ * smallest period, i.e., if it has no period p / r for a prime factor r of p.
+ * This takes O(n log(max_period)) LCE queries.
+ *
+ * The periods are processed in parallel. Each thread buffers its runs and
+ * passes them to emit(runs), where runs is a span of text_run, so emit is
+ * called by one thread at a time, but in no particular order. Returns the
+ * number of runs. */
+template <LceBackwardBackend backend_type, typename callback_type>
+uint64_t compute_runs(backend_type const& ds, uint64_t const text_size,
+                      callback_type&& emit, uint64_t const min_period = 1,
+                      uint64_t const max_period = std::numeric_limits<uint64_t>::max()) {
+  constexpr size_t kFlushSize = size_t{1} << 16;
+  uint64_t const last_period = std::min(max_period, text_size / 2);
+  uint64_t num_runs = 0;
+
+#pragma omp parallel reduction(+ : num_runs)
+  {
+    std::vector<text_run> runs;
+    std::vector<uint64_t> smaller_periods;
+    auto const flush = [&]() {
+#pragma omp critical(lce_runs_emit)
+      emit(std::span<text_run const>(runs));
+      num_runs += runs.size();
+      runs.clear();
+    };
+
+#pragma omp for schedule(dynamic, 1)
+    for (uint64_t p = std::max<uint64_t>(min_period, 1); p <= last_period; ++p) {
+      // Maximal proper divisors of p, which are the only candidates for a
+      // smaller period of a repetition with period p
+      smaller_periods.clear();
+      uint64_t rest = p;
+      for (uint64_t r = 2; r * r <= rest; ++r) {
+        if (rest % r == 0) {
+          smaller_periods.push_back(p / r);
+          while (rest % r == 0) {
+            rest /= r;
+          }
+        }
+      }
+      if (rest > 1) {
+        smaller_periods.push_back(p / rest);
+      }
+
+      for (uint64_t i = 0; i + p < text_size; i += p) {
+        uint64_t const forward = ds.lce_bounded(i, i + p, text_size - i - p);
+        uint64_t const backward = (i > 0) ? ds.lce_backward_bounded(i - 1, i + p - 1, p) : 0;
+        if (backward == p || forward + backward < p) {
+          continue;
+        }
+        uint64_t const start = i - backward;
+        uint64_t const length = backward + p + forward;
+        bool const primitive = std::none_of(
+            smaller_periods.begin(), smaller_periods.end(),
+            [&](uint64_t const q) {
+              return ds.lce_bounded(start, start + q, length - q) == length - q;
+            });
+        if (primitive) {
+          runs.push_back({start, length, p});
+          if (runs.size() == kFlushSize) {
+            flush();
+          }
+        }
+      }
+    }
+    if (!runs.empty()) {
+      flush();
+    }
+  }
+  return num_runs;
+}
+
+} // namespace lce_test
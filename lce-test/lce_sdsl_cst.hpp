@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
 #include <vector>
 
@@ -16,10 +17,10 @@
 #include "sdsl/cst_sada.hpp"
 #include "sdsl/cst_sct3.hpp"
 
-#include "util/lce_interface.hpp"
+#include "util/lce_backend.hpp"
 
 template <typename t_index>
-class LceSDSL : public LceDataStructure {
+class LceSDSL {
 
   t_index cst_;
   uint64_t size_;
@@ -32,7 +33,7 @@ public:
 
   ~LceSDSL() { }
 
-  uint64_t lce(uint64_t const i, uint64_t const j) {
+  uint64_t lce(uint64_t const i, uint64_t const j) const {
     if (TLX_UNLIKELY(i == j)) {
       return getSizeInBytes() - 1 - i;
     }
@@ -43,19 +44,31 @@ public:
     return cst_.depth(cst_.node(std::min(ip, jp), std::max(ip, jp)));
   };
 
-  char operator[]([[maybe_unused]] const uint64_t i) { return 0; }
+  /* The CST has no early exit, so the cap only limits the result. */
+  uint64_t lce_bounded(uint64_t const i, uint64_t const j,
+                       uint64_t const cap) const {
+    return std::min(lce(i, j), cap);
+  }
+
+  char operator[]([[maybe_unused]] const uint64_t i) const { return 0; }
 
-  int32_t isSmallerSuffix(uint64_t const i, uint64_t const j) {
+  int32_t isSmallerSuffix(uint64_t const i, uint64_t const j) const {
     uint64_t const ip = cst_.csa.isa[i];
     uint64_t const jp = cst_.csa.isa[j];
 
     return ip < jp;
   }
 
-  uint64_t getSizeInBytes() {
+  uint64_t getSizeInBytes() const {
     return size_;
   }
 
+  lce_test::memory_report memory_breakdown() const {
+    lce_test::memory_report report;
+    report.add("cst", sdsl::size_in_bytes(cst_));
+    return report;
+  }
+
 }; // class LceSDSL
 
 using LceSDSLsada = LceSDSL<sdsl::cst_sada<>>;
@@ -9,7 +9,9 @@
 
 #pragma once
 
-#include "util/lce_interface.hpp"
+#include "util/lce_backend.hpp"
+#include "util/naive_lce.hpp"
+#include "util/phase_profiler.hpp"
 #include "util/synchronizing_sets/bit_vector_rank.hpp"
 #include "util/synchronizing_sets/ring_buffer.hpp"
 #include "util/synchronizing_sets/lce-rmq.hpp"
@@ -22,17 +24,13 @@
 #include <vector>
 #include <memory>
 
-#ifdef DETAILED_TIME
-#include <malloc_count.h>
-#endif
-
 
 
 /* This class stores a text as an array of characters and 
  * answers LCE-queries with the naive method. */
 
 template <uint64_t kTau = 1024, bool prefer_long = true>
-class LceSemiSyncSets : public LceDataStructure {
+class LceSemiSyncSets {
 
 public:
   __extension__ typedef unsigned __int128 uint128_t;
@@ -65,55 +63,29 @@ public:
     }
     ring_buffer<uint64_t> fingerprints(4*kTau);
 
-#ifdef DETAILED_TIME
-    size_t mem_before = malloc_count_current();
-    malloc_count_reset_peak();
-    std::chrono::system_clock::time_point begin = std::chrono::system_clock::now();
-#endif
-
+    profiler_.start("sss_construct");
     std::vector<uint64_t> s_fingerprints;
     fingerprints.push_back(static_cast<uint64_t>(fp));
     fill_synchronizing_set(0, (text_length_in_bytes_ - (2*kTau)), fp,
                            fingerprints, s_fingerprints);
-    
-#ifdef DETAILED_TIME
-    std::chrono::system_clock::time_point end = std::chrono::system_clock::now();
-    if (print_ss_size) {
-      std::cout << "sss_construct_time=" 
-                << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << " "
-                << "sss_construct_mem=" << (malloc_count_peak() - mem_before) << " "
-                << "sss_size=" << sync_set_.size() << " ";
-    }
-#endif
-
-#ifdef DETAILED_TIME
-    mem_before = malloc_count_current();
-    malloc_count_reset_peak();
-    begin = std::chrono::system_clock::now();
-#endif
+    profiler_.stop();
+    profiler_.set("sss_size", sync_set_.size());
 
+    profiler_.start("pred_construct");
     ind_ = std::make_unique<stash::pred::index<std::vector<sss_type>, sss_type, 7>>(sync_set_);
-
-#ifdef DETAILED_TIME
-    end = std::chrono::system_clock::now();
-    if (print_ss_size) {
-      std::cout << "pred_construct_time=" 
-                << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << " "
-                << "pred_construct_mem=" << (malloc_count_peak() - mem_before) << " ";
-    }
-#endif
+    profiler_.stop();
 
     lce_rmq_ = std::make_unique<Lce_rmq<sss_type, kTau>>(text_.data(),
                                                          text_length_in_bytes_,
                                                          sync_set_,
-                                                         print_ss_size);
+                                                         profiler_);
     if (print_ss_size) {
       std::cout << "sync_set_size=" << getSyncSetSize() << " ";
     }
   }
 
   /* Answers the lce query for position i and j */
-  inline uint64_t lce(const uint64_t i, const uint64_t j) {
+  inline uint64_t lce(const uint64_t i, const uint64_t j) const {
     if (TLX_UNLIKELY(i == j)) {
       return text_length_in_bytes_ - i;
     }
@@ -212,21 +184,57 @@ public:
     }
   }
 
-  char operator[](uint64_t i) {
+  /* Returns min(lce(i, j), cap). If cap is at most 3 * kTau, the query is
+     answered by scanning the text, i.e., without the successor data structure
+     and the RMQ. */
+  inline uint64_t lce_bounded(const uint64_t i, const uint64_t j,
+                              const uint64_t cap) const {
+    uint64_t const max_length =
+        std::min(cap, text_length_in_bytes_ - std::max(i, j));
+    if (TLX_UNLIKELY(i == j)) {
+      return max_length;
+    }
+    if (max_length <= 3 * kTau) {
+      return lce_test::naive_lce(text_.data(), i, j, max_length);
+    }
+    return std::min(lce(i, j), cap);
+  }
+
+  char operator[](uint64_t i) const {
     if(i > text_length_in_bytes_) {return '\00';}
     return text_[i];
   }
     
-  int isSmallerSuffix([[maybe_unused]] const uint64_t i,
-                      [[maybe_unused]] const uint64_t j) {
-    return 0;
+  int isSmallerSuffix(const uint64_t i, const uint64_t j) const {
+    uint64_t const lce_s = lce(i, j);
+    // Suffix j is a prefix of suffix i (or i == j)
+    if (TLX_UNLIKELY(j + lce_s >= text_length_in_bytes_)) {
+      return false;
+    }
+    if (TLX_UNLIKELY(i + lce_s >= text_length_in_bytes_)) {
+      return true;
+    }
+    return text_[i + lce_s] < text_[j + lce_s];
   }
     
-  size_t getSizeInBytes() {
-    return text_length_in_bytes_;
+  size_t getSizeInBytes() const {
+    return memory_breakdown().total();
+  }
+
+  lce_test::memory_report memory_breakdown() const {
+    lce_test::memory_report report;
+    report.add("text", text_length_in_bytes_);
+    report.add("sss", lce_test::bytes_of(sync_set_));
+    report.add("pred", ind_->size_in_bytes());
+    report.add("lce_rmq", lce_rmq_->memory_breakdown());
+    return report;
+  }
+
+  lce_test::phase_profiler const& getPhaseProfile() const {
+    return profiler_;
   }
 
-  size_t getSyncSetSize() {
+  size_t getSyncSetSize() const {
     return sync_set_.size();
   }
 
@@ -318,6 +326,7 @@ private:
   std::unique_ptr<stash::pred::index<std::vector<uint32_t>, uint32_t, 7>> ind_;
   std::vector<sss_type> sync_set_;
   std::unique_ptr<Lce_rmq<sss_type, kTau>> lce_rmq_;
+  lce_test::phase_profiler profiler_;
 };
 
 /******************************************************************************/
@@ -9,80 +9,73 @@
 
 #pragma once
 
+#include <algorithm>
 #include <chrono>
 #include <cmath>
 #include <memory>
+#include <span>
+#include <string>
 #include <tlx/define/likely.hpp>
 #include <vector>
 
-#include "util/lce_interface.hpp"
-#include "util/successor/index_par.hpp"
+#include "util/lce_backend.hpp"
+#include "util/naive_lce.hpp"
+#include "util/numa.hpp"
+#include "util/phase_profiler.hpp"
+#include "util/reversed_text_view.hpp"
+#include "util/successor/sss_index.hpp"
 #include "util/util.hpp"
 #include "util_ssss_par/lce-rmq.hpp"
 #include "util_ssss_par/ssss_par.hpp"
 #include "util_ssss_par/sss_checker.hpp"
-
-#ifdef DETAILED_TIME
-#include <malloc_count.h>
-#endif
+#include "util_ssss_par/sss_fingerprints.hpp"
 
 namespace lce_test::par {
 __extension__ typedef unsigned __int128 uint128_t;
 /* This class stores a text as an array of characters and 
- * answers LCE-queries with the naive method. */
-template <uint64_t kTau = 1024>
-class LceSemiSyncSetsPar : public LceDataStructure {
+ * answers LCE-queries with the naive method. isa_type is the width of the
+ * inverse suffix array and the RMQ positions on the reduced text (see
+ * Lce_rmq_par); uint64_t is only needed for more than 2^32 - 1 string
+ * synchronizing set positions. */
+template <uint64_t kTau = 1024, typename isa_type = uint32_t>
+class LceSemiSyncSetsPar {
  public:
   using sss_type = uint64_t;
+  using lce_rmq_type = Lce_rmq_par<sss_type, kTau, uint8_t const*, isa_type>;
+  // Successor index sampled at a rate that follows kTau (see sss_index)
+  using index_type = stash::pred::sss_index<lce_test::numa_vector<sss_type>, sss_type, kTau>;
+  static constexpr size_t kBatchSize = 16;
+  // Number of doublings of the fingerprint search before using the RMQ
+  static constexpr size_t kFingerprintSteps = 4;
 
  public:
-  LceSemiSyncSetsPar(std::vector<uint8_t> const& text, bool const print_ss_size)
-      : text_(text), text_length_in_bytes_(text_.size()) {
-#ifdef DETAILED_TIME
-    size_t mem_before = malloc_count_current();
-    malloc_count_reset_peak();
-    std::chrono::system_clock::time_point begin = std::chrono::system_clock::now();
-#endif
-
+  /* ranking selects how the strings at the synchronizing positions are
+     ranked (see sss_ranking). */
+  LceSemiSyncSetsPar(std::vector<uint8_t> const& text, [[maybe_unused]] bool const print_ss_size,
+                     sss_ranking const ranking = sss_ranking::string_sort)
+      : text_(text), text_length_in_bytes_(text_.size()), ranking_(ranking) {
+    profiler_.start("sss_construct");
     sync_set_ = string_synchronizing_set_par<kTau, sss_type>(text_);
     //check_string_synchronizing_set(text, sync_set_);
     //print_sss();
+    profiler_.stop();
+    build_query_structures();
+  }
 
-#ifdef DETAILED_TIME
-    std::chrono::system_clock::time_point end = std::chrono::system_clock::now();
-    if (print_ss_size) {
-      std::cout << "sss_construct_time="
-                << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << " "
-                << "sss_construct_mem=" << (malloc_count_peak() - mem_before) << " "
-                << "sss_size=" << sync_set_.size() << " "
-                << "sss_repetetive=" << std::boolalpha << sync_set_.has_runs() << " "
-                << "sss_runs=" << sync_set_.num_runs() << " ";
-    }
-#endif
-
-#ifdef DETAILED_TIME
-    mem_before = malloc_count_current();
-    malloc_count_reset_peak();
-    begin = std::chrono::system_clock::now();
-#endif
-
-    ind_ = std::make_unique<stash::pred::index_par<std::vector<sss_type>, sss_type, 7>>(sync_set_.get_sss());
-
-#ifdef DETAILED_TIME
-    end = std::chrono::system_clock::now();
-    if (print_ss_size) {
-      std::cout << "pred_construct_time="
-                << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << " "
-                << "pred_construct_mem=" << (malloc_count_peak() - mem_before) << " ";
-    }
-#endif
-    lce_rmq_ = std::make_unique<Lce_rmq_par<sss_type, kTau>>(text_.data(),
-                                                             text_length_in_bytes_,
-                                                             sync_set_);
+  /* Builds the data structure for text, which starts with the text of
+     prefix. The synchronizing positions of prefix are reused (see
+     string_synchronizing_set_par), the other structures are built again. */
+  LceSemiSyncSetsPar(std::vector<uint8_t> const& text, LceSemiSyncSetsPar const& prefix)
+      : text_(text), text_length_in_bytes_(text_.size()), ranking_(prefix.ranking_) {
+    profiler_.start("sss_construct");
+    sync_set_ = string_synchronizing_set_par<kTau, sss_type>(text_, prefix.sync_set_,
+                                                             prefix.text_length_in_bytes_);
+    profiler_.stop();
+    build_query_structures();
   }
 
   /* Answers the lce query for position i and j */
-  inline uint64_t lce(uint64_t i, uint64_t j) {
+  inline uint64_t lce(uint64_t i, uint64_t j) const {
     if (TLX_UNLIKELY(i == j)) {
       return text_length_in_bytes_ - i;
     }
@@ -91,73 +84,204 @@ class LceSemiSyncSetsPar : public LceDataStructure {
     }
 
     /* naive part */
-    uint64_t const sync_length = 3 * kTau;
-    uint64_t const max_length = std::min(sync_length, text_length_in_bytes_ - j);
-    uint64_t lce = 0;
-    for (; lce < 8; ++lce) {
-      if (TLX_UNLIKELY(lce >= max_length)) {
-        return max_length;
+    uint64_t const max_length = std::min(3 * kTau, text_length_in_bytes_ - j);
+    uint64_t const lce = lce_test::naive_lce(text_.data(), i, j, max_length);
+    if (lce < 3 * kTau) {
+      return lce;
+    }
+
+    /* strSync part */
+    if (TLX_UNLIKELY(!replicas_.empty())) {
+      numa_replica const& replica = *replicas_[local_replica()];
+      return sync_lce(i, j, replica.sync_set, replica.ind, replica.lce_rmq, fingerprints_.get());
+    }
+    return sync_lce(i, j, sync_set_.get_sss(), *ind_, *lce_rmq_, fingerprints_.get());
+  }
+
+  /* Returns min(lce(i, j), cap). If cap is at most 3 * kTau, the query is
+     answered by scanning the text, i.e., without touching the successor
+     index or the RMQ. */
+  inline uint64_t lce_bounded(uint64_t const i, uint64_t const j,
+                              uint64_t const cap) const {
+    uint64_t const max_length =
+        std::min(cap, text_length_in_bytes_ - std::max(i, j));
+    if (TLX_UNLIKELY(i == j)) {
+      return max_length;
+    }
+    if (max_length <= 3 * kTau) {
+      return lce_test::naive_lce(text_.data(), i, j, max_length);
+    }
+    return std::min(lce(i, j), cap);
+  }
+
+  /* Answers the queries (indices[2k], indices[2k + 1]) in groups of
+     kBatchSize. The text at all positions of a group is prefetched first, so
+     the cache misses of the naive parts overlap. */
+  void lce_batch(std::span<uint64_t const> const indices,
+                 std::span<uint64_t> const results) const {
+    for (size_t first = 0; first < results.size(); first += kBatchSize) {
+      size_t const last = std::min(results.size(), first + kBatchSize);
+      for (size_t k = first; k < last; ++k) {
+        __builtin_prefetch(text_.data() + indices[2 * k]);
+        __builtin_prefetch(text_.data() + indices[2 * k + 1]);
       }
-      if (text_[i + lce] != text_[j + lce]) {
-        return lce;
+      for (size_t k = first; k < last; ++k) {
+        results[k] = lce(indices[2 * k], indices[2 * k + 1]);
       }
     }
+  }
 
-    lce = 0;
-    uint128_t const* const text_blocks_i =
-        reinterpret_cast<uint128_t const*>(text_.data() + i);
-    uint128_t const* const text_blocks_j =
-        reinterpret_cast<uint128_t const*>(text_.data() + j);
-    for (; lce < max_length / 16; ++lce) {
-      if (text_blocks_i[lce] != text_blocks_j[lce]) {
-        lce *= 16;
-        // The last block did not match. Here we compare its single characters
-        uint64_t lce_end = std::min(lce + 16, max_length);
-        for (; lce < lce_end; ++lce) {
-          if (text_[i + lce] != text_[j + lce]) {
-            return lce;
-          }
-        }
-        return lce;
-      }
+  /* Builds Karp-Rabin fingerprints at the synchronizing positions. Afterwards,
+   * forward queries compare the text between the synchronizing positions
+   * following i and j with an exponential search on the fingerprints, which
+   * only reads a few neighboring entries if the LCE is short. Only if the
+   * search takes more than kFingerprintSteps doublings, i.e., if the LCE is
+   * long, the inverse suffix array and the RMQ are used. If the text has long
+   * runs, the gaps between the synchronizing positions may be long, so no
+   * fingerprints are built and all queries use the RMQ. */
+  void build_fingerprints() {
+    if (sync_set_.has_runs()) {
+      return;
     }
-    lce *= 16;
+    profiler_.start("fingerprint_construct");
+    fingerprints_ = std::make_unique<sss_fingerprints<sss_type>>(text_.data(), text_length_in_bytes_,
+                                                                 sync_set_.get_sss());
+    profiler_.stop();
+  }
 
-    /* strSync part */
-    uint64_t const i_ = suc(i + 1);
-    uint64_t const j_ = suc(j + 1);
+  bool has_fingerprints() const {
+    return fingerprints_ != nullptr;
+  }
 
-    uint64_t const i_diff = sync_set_[i_] - i;
-    uint64_t const j_diff = sync_set_[j_] - j;
+  /* Builds the reverse-oriented string synchronizing set, successor index and
+   * RMQ, which answer backward LCE queries. They are built over a reversed
+   * view of the text, i.e., the text itself is shared. */
+  void build_backward() {
+    profiler_.start("backward_construct");
+    // The phases of the backward structures are summarized in one phase
+    lce_test::phase_profiler backward_profiler;
+    backward_ = std::make_unique<backward_index>(text_, backward_profiler, ranking_);
+    backward_profiler.stop();
+    profiler_.stop();
+  }
 
-    if (i_diff == j_diff) {
-      return i_diff + lce_rmq_->lce(i_, j_);
-    } else {
-      return std::min(i_diff, j_diff) + 2 * kTau - 1;
+  bool has_backward() const {
+    return backward_ != nullptr;
+  }
+
+  /* Answers the backward lce query, i.e., the length of the longest common
+   * suffix of T[0, i] and T[0, j]. Requires build_backward(). */
+  inline uint64_t lce_backward(uint64_t i, uint64_t j) const {
+    if (TLX_UNLIKELY(i == j)) {
+      return i + 1;
     }
+    if (i < j) {
+      std::swap(i, j);
+    }
+
+    /* naive part */
+    uint64_t const max_length = std::min(3 * kTau, j + 1);
+    uint64_t const lcs =
+        lce_test::naive_lce_backward(text_.data(), i, j, max_length);
+    if (lcs < 3 * kTau) {
+      return lcs;
+    }
+
+    /* strSync part on the reversed text */
+    return sync_lce(backward_->view.mirror(i), backward_->view.mirror(j),
+                    backward_->sync_set.get_sss(), backward_->ind,
+                    backward_->lce_rmq);
   }
-  char operator[](size_t i) {
+
+  /* Returns min(lce_backward(i, j), cap). If cap is at most 3 * kTau, only
+   * the text is scanned (and build_backward() is not required). */
+  inline uint64_t lce_backward_bounded(uint64_t const i, uint64_t const j,
+                                       uint64_t const cap) const {
+    uint64_t const max_length = std::min(cap, std::min(i, j) + 1);
+    if (TLX_UNLIKELY(i == j)) {
+      return max_length;
+    }
+    if (max_length <= 3 * kTau) {
+      return lce_test::naive_lce_backward(text_.data(), i, j, max_length);
+    }
+    return std::min(lce_backward(i, j), cap);
+  }
+
+  /* Replicates the read-only query arrays (sync set, successor index, isa,
+   * lcp and RMQ) on each NUMA node. Afterwards, queries use the replica on the
+   * node of the calling thread, so query threads should be pinned (e.g., using
+   * OMP_PROC_BIND). Does nothing on machines with a single node. */
+  void replicate_numa() {
+    replicas_.clear();
+    int const num_nodes = lce_test::numa_num_nodes();
+    if (num_nodes <= 1) {
+      return;
+    }
+    profiler_.start("numa_replicate");
+    for (int node = 0; node < num_nodes; ++node) {
+      replicas_.push_back(std::make_unique<numa_replica>(*this, node));
+    }
+    profiler_.stop();
+  }
+  char operator[](size_t i) const {
     if (i > text_length_in_bytes_) {
       return '\00';
     }
     return text_[i];
   }
 
-  int isSmallerSuffix([[maybe_unused]] const uint64_t i,
-                      [[maybe_unused]] const uint64_t j) {
-    return 0;
+  int isSmallerSuffix(const uint64_t i, const uint64_t j) const {
+    uint64_t const lce_s = lce(i, j);
+    // Suffix j is a prefix of suffix i (or i == j)
+    if (TLX_UNLIKELY(j + lce_s >= text_length_in_bytes_)) {
+      return false;
+    }
+    if (TLX_UNLIKELY(i + lce_s >= text_length_in_bytes_)) {
+      return true;
+    }
+    return text_[i + lce_s] < text_[j + lce_s];
+  }
+
+  size_t getSizeInBytes() const {
+    return memory_breakdown().total();
+  }
+
+  lce_test::memory_report memory_breakdown() const {
+    lce_test::memory_report report;
+    report.add("text", text_length_in_bytes_);
+    report.add("sss", sync_set_.memory_breakdown());
+    report.add("pred", ind_->size_in_bytes());
+    report.add("lce_rmq", lce_rmq_->memory_breakdown());
+    if (fingerprints_) {
+      report.add("fingerprints", fingerprints_->memory_breakdown());
+    }
+    if (backward_) {
+      lce_test::memory_report backward_report;
+      backward_report.add("sss", backward_->sync_set.memory_breakdown());
+      backward_report.add("pred", backward_->ind.size_in_bytes());
+      backward_report.add("lce_rmq", backward_->lce_rmq.memory_breakdown());
+      report.add("backward", backward_report);
+    }
+    for (size_t node = 0; node < replicas_.size(); ++node) {
+      lce_test::memory_report replica_report;
+      replica_report.add("sss", lce_test::bytes_of(replicas_[node]->sync_set));
+      replica_report.add("pred", replicas_[node]->ind.size_in_bytes());
+      replica_report.add("lce_rmq", replicas_[node]->lce_rmq.memory_breakdown());
+      report.add("replica" + std::to_string(node), replica_report);
+    }
+    return report;
   }
 
-  size_t getSizeInBytes() {
-    return text_length_in_bytes_;
+  lce_test::phase_profiler const& getPhaseProfile() const {
+    return profiler_;
   }
 
-  size_t getSyncSetSize() {
+  size_t getSyncSetSize() const {
     return sync_set_.size();
   }
 
-  std::vector<sss_type> getSyncSet() {
-    return sync_set_.get_sss();
+  std::vector<sss_type> getSyncSet() const {
+    return {sync_set_.get_sss().begin(), sync_set_.get_sss().end()};
   }
 
   void print_sss() {
@@ -168,20 +292,151 @@ class LceSemiSyncSetsPar : public LceDataStructure {
   }
 
  private:
-  /* Finds the smallest element that is greater or equal to i
-     Because s_ is ordered, that is equal to the 
-     first element greater than i */
-  inline sss_type suc(sss_type i) const {
-    return ind_->successor(i).pos;
+  /* Copy of the query arrays bound to one NUMA node */
+  struct numa_replica {
+    numa_replica(LceSemiSyncSetsPar const& lce_sss, int const node)
+        : sync_set(lce_test::numa_copy(lce_sss.sync_set_.get_sss(), node)),
+          ind(*lce_sss.ind_, sync_set, node),
+          lce_rmq(*lce_sss.lce_rmq_, node) {}
+
+    lce_test::numa_vector<sss_type> const sync_set;
+    index_type const ind;
+    lce_rmq_type const lce_rmq;
+  };
+
+  /* Reverse-oriented query structures, built over a reversed view of the
+     text */
+  struct backward_index {
+    backward_index(std::vector<uint8_t> const& text,
+                   lce_test::phase_profiler& profiler, sss_ranking const ranking)
+        : view(text.data(), text.size()),
+          sync_set(view),
+          ind(sync_set.get_sss()),
+          lce_rmq(view.cbegin(), view.size(), sync_set, profiler, ranking) {}
+
+    lce_test::reversed_text_view const view;
+    string_synchronizing_set_par<kTau, sss_type> const sync_set;
+    index_type const ind;
+    Lce_rmq_par<sss_type, kTau, lce_test::reversed_text_view::const_iterator, isa_type> const lce_rmq;
+  };
+
+  /* Builds the successor index and the RMQ on the reduced text for
+     sync_set_ */
+  void build_query_structures() {
+    profiler_.set("sss_size", sync_set_.size());
+    profiler_.set("sss_repetetive", sync_set_.has_runs());
+    profiler_.set("sss_runs", sync_set_.num_runs());
+
+    profiler_.start("pred_construct");
+    ind_ = std::make_unique<index_type>(sync_set_.get_sss());
+    profiler_.stop();
+
+    lce_rmq_ = std::make_unique<lce_rmq_type>(text_.data(),
+                                              text_length_in_bytes_,
+                                              sync_set_,
+                                              profiler_,
+                                              ranking_);
+  }
+
+  /* Answers the query using the synchronizing positions following i and j.
+     For finding these, we look for the smallest element that is greater or
+     equal to i + 1 (resp. j + 1). Because the sync set is ordered, that is
+     equal to the first element greater than i (resp. j). If fingerprints
+     are given, the LCE of the synchronizing positions is computed with them
+     (see fingerprint_lce). */
+  template <typename lce_rmq_type>
+  inline uint64_t sync_lce(uint64_t const i, uint64_t const j,
+                           lce_test::numa_vector<sss_type> const& sync_set,
+                           index_type const& ind,
+                           lce_rmq_type const& lce_rmq,
+                           sss_fingerprints<sss_type> const* fingerprints = nullptr) const {
+    uint64_t const i_ = ind.successor(i + 1).pos;
+    uint64_t const j_ = ind.successor(j + 1).pos;
+
+    uint64_t const i_diff = sync_set[i_] - i;
+    uint64_t const j_diff = sync_set[j_] - j;
+
+    if (i_diff == j_diff) {
+      if (fingerprints != nullptr) {
+        return i_diff + fingerprint_lce(i_, j_, sync_set, lce_rmq, *fingerprints);
+      }
+      return i_diff + lce_rmq.lce(i_, j_);
+    } else {
+      return std::min(i_diff, j_diff) + 2 * kTau - 1;
+    }
+  }
+
+  /* LCE of the synchronizing positions with indices a and b. We search for
+     the largest k, such that the next k synchronizing positions have the same
+     distances from a and b and the texts up to them have the same
+     fingerprints. Then, the texts differ before the next synchronizing
+     position plus 2 * kTau (otherwise, the next positions would have the same
+     distances, too), which is scanned. Long searches and long scans are
+     answered by the RMQ instead. The set has no runs (see
+     build_fingerprints). */
+  template <typename lce_rmq_type>
+  inline uint64_t fingerprint_lce(uint64_t const a, uint64_t const b,
+                                  lce_test::numa_vector<sss_type> const& sync_set,
+                                  lce_rmq_type const& lce_rmq,
+                                  sss_fingerprints<sss_type> const& fingerprints) const {
+    uint64_t const max_k = sync_set.size() - 1 - std::max(a, b);
+    auto const matches = [&](uint64_t const k) {
+      return sync_set[a + k] - sync_set[a] == sync_set[b + k] - sync_set[b] &&
+             fingerprints.equal(a, b, k);
+    };
+
+    // matches(low) holds and matches(high) does not (if high <= max_k)
+    uint64_t low = 0;
+    uint64_t high = 1;
+    for (size_t step = 0; high <= max_k && matches(high); ++step) {
+      if (step == kFingerprintSteps) {
+        return lce_rmq.lce(a, b);
+      }
+      low = high;
+      high *= 2;
+    }
+    high = std::min(high, max_k + 1);
+    while (high - low > 1) {
+      uint64_t const mid = low + (high - low) / 2;
+      if (matches(mid)) {
+        low = mid;
+      } else {
+        high = mid;
+      }
+    }
+
+    uint64_t const x = sync_set[a + low];
+    uint64_t const y = sync_set[b + low];
+    uint64_t const x_gap = (a + low + 1 < sync_set.size()) ? sync_set[a + low + 1] - x
+                                                          : text_length_in_bytes_ - x;
+    uint64_t const y_gap = (b + low + 1 < sync_set.size()) ? sync_set[b + low + 1] - y
+                                                          : text_length_in_bytes_ - y;
+    uint64_t const max_length = std::min(std::min(x_gap, y_gap) + 2 * kTau,
+                                         text_length_in_bytes_ - std::max(x, y));
+    if (TLX_UNLIKELY(max_length > 4 * kTau)) {
+      return (x - sync_set[a]) + lce_rmq.lce(a + low, b + low);
+    }
+    return (x - sync_set[a]) + lce_test::naive_lce(text_.data(), x, y, max_length);
+  }
+
+  /* Replica of the calling thread. The node is determined once per thread. */
+  inline size_t local_replica() const {
+    static thread_local size_t const node = lce_test::numa_current_node();
+    return std::min(node, replicas_.size() - 1);
   }
 
  private:
   std::vector<uint8_t> const& text_;
   size_t const text_length_in_bytes_;
+  sss_ranking const ranking_;
 
-  std::unique_ptr<stash::pred::index_par<std::vector<sss_type>, sss_type, 7>> ind_;
+  std::unique_ptr<index_type> ind_;
   string_synchronizing_set_par<kTau, sss_type> sync_set_;
-  std::unique_ptr<Lce_rmq_par<sss_type, kTau>> lce_rmq_;
+  std::unique_ptr<lce_rmq_type> lce_rmq_;
+  std::vector<std::unique_ptr<numa_replica>> replicas_;
+  std::unique_ptr<backward_index> backward_;
+  std::unique_ptr<sss_fingerprints<sss_type>> fingerprints_;
+  lce_test::phase_profiler profiler_;
 };
 }  // namespace lce_test::par
 /******************************************************************************/
@@ -0,0 +1,408 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <limits>
+#include <memory>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <tlx/define/likely.hpp>
+
+#include "lce_semi_synchronizing_sets_par.hpp"
+#include "util/fingerprint_policy.hpp"
+#include "util/memory_report.hpp"
+#include "util/naive_lce.hpp"
+#include "util/phase_profiler.hpp"
+#include "util/prezza_blocks.hpp"
+
+namespace lce_test::par {
+
+/* LCE queries on a text that grows at its end, e.g., an append-only log. The
+ * text is indexed by the logarithmic method: it is split into consecutive
+ * parts, each of which is indexed by an immutable LceSemiSyncSetsPar, and
+ * each part is more than twice as long as the next one, so there are
+ * O(log(n)) of them. Appended characters are collected in a buffer. Once it
+ * has min_index_size characters, it is merged with the last parts (as long as
+ * they are at most twice as long as the merged text) into a new part in a
+ * background thread, while queries and appends go on with the old parts.
+ * Each character takes part in O(log(n)) merges. If the first merged part
+ * starts the merged text, its synchronizing positions are reused, so only
+ * those of the other parts are computed again.
+ *
+ * Additionally, the Karp-Rabin fingerprints (modulo a random prime, see
+ * fingerprint_policy.hpp) of the prefixes T[0, k * kFingerprintSample) are
+ * kept, which only grow on append. A query is answered by the index of a part
+ * if both positions are in it, and the remaining match, i.e., if the
+ * positions are in different parts or the buffer, or if the match reaches the
+ * end of the part, by an exponential search on the fingerprints. Hence,
+ * appended characters can be queried at once, in O(log(n)) fingerprint
+ * comparisons of O(kFingerprintSample / 8) time each.
+ *
+ * The text is stored once (in the parts and the buffer). A merge copies the
+ * merged text (see memory_breakdown), and its construction needs O(n / kTau)
+ * words for the synchronizing positions, the reduced text and its suffix and
+ * LCP arrays. Queries are const and may run concurrently, but not
+ * concurrently with append. */
+template <uint64_t kTau = 1024>
+class LceSemiSyncSetsParAppend {
+  __extension__ typedef unsigned __int128 uint128_t;
+
+  // Characters per sampled prefix fingerprint. The parts start at multiples
+  // of it, so the characters between two samples are stored contiguously.
+  static constexpr uint64_t kFingerprintSample = 128;
+  // Matches not answered by a part are scanned up to this length before the
+  // fingerprints are searched
+  static constexpr uint64_t kNaiveScan = 256;
+  static_assert(std::has_single_bit(kNaiveScan));
+
+ public:
+  /* The buffer is indexed once it has at least min_index_size characters. */
+  explicit LceSemiSyncSetsParAppend(std::vector<uint8_t> const& text = {},
+                                    sss_ranking const ranking = sss_ranking::string_sort,
+                                    uint64_t const min_index_size = uint64_t{1} << 24)
+      : ranking_(ranking),
+        min_index_size_(std::max(min_index_size, 16 * kTau) / kFingerprintSample *
+                        kFingerprintSample),
+        powers_(lce_test::prezza_powers(fingerprint_)),
+        fingerprints_(1, 0) {
+    append(text);
+    wait_for_rebuild();
+  }
+
+  /* Appends the bytes to the text. If a merge has finished, its part is used
+     from now on; if the buffer has become large enough, a merge is
+     started. */
+  void append(std::span<uint8_t const> bytes) {
+    while (!bytes.empty()) {
+      uint64_t const length =
+          std::min<uint64_t>(bytes.size(), kFingerprintSample - size() % kFingerprintSample);
+      fingerprint_end_ = extend(fingerprint_end_, bytes.data(), length);
+      buffer_.insert(buffer_.end(), bytes.begin(), bytes.begin() + length);
+      if (size() % kFingerprintSample == 0) {
+        fingerprints_.push_back(fingerprint_end_);
+      }
+      bytes = bytes.subspan(length);
+    }
+    if (rebuilding() && pending_.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+      install(pending_.get());
+    }
+    if (!rebuilding() && buffer_.size() >= min_index_size_) {
+      start_rebuild(false);
+    }
+  }
+
+  /* Whether a merge is running in the background */
+  bool rebuilding() const {
+    return pending_.valid();
+  }
+
+  /* Waits for the running merge (if any) and uses its part */
+  void wait_for_rebuild() {
+    if (rebuilding()) {
+      install(pending_.get());
+    }
+  }
+
+  /* Indexes the buffer now (except for less than kFingerprintSample
+     characters at the end), e.g., after the last append */
+  void rebuild() {
+    wait_for_rebuild();
+    if (start_rebuild(true)) {
+      wait_for_rebuild();
+    }
+  }
+
+  uint64_t size() const {
+    return indexed_size() + buffer_.size();
+  }
+
+  /* Length of the prefix that is covered by the parts */
+  uint64_t indexed_size() const {
+    return parts_.empty() ? 0 : begins_.back() + parts_.back()->text.size();
+  }
+
+  /* Number of parts */
+  size_t num_parts() const {
+    return parts_.size();
+  }
+
+  inline uint64_t lce(uint64_t const i, uint64_t const j) const {
+    return lce_bounded(i, j, std::numeric_limits<uint64_t>::max());
+  }
+
+  /* Returns min(lce(i, j), cap). The index of a part is queried if both
+     positions are in it. A match that reaches the end of the part is
+     continued with the fingerprints. */
+  inline uint64_t lce_bounded(uint64_t i, uint64_t j, uint64_t const cap) const {
+    if (i > j) {
+      std::swap(i, j);
+    }
+    uint64_t const max_length = std::min(cap, size() - j);
+    if (TLX_UNLIKELY(i == j)) {
+      return max_length;
+    }
+    uint64_t lce = 0;
+    if (j < indexed_size()) {
+      size_t const k = part_of(j);
+      uint64_t const begin = begins_[k];
+      if (i >= begin) {
+        part const& p = *parts_[k];
+        lce = p.lce.lce_bounded(i - begin, j - begin, max_length);
+        if (lce == max_length || j + lce < begin + p.text.size()) {
+          return lce;
+        }
+      }
+    }
+    return lce + fingerprint_lce(i + lce, j + lce, max_length - lce);
+  }
+
+  char operator[](uint64_t const i) const {
+    auto const bytes = bytes_from(i);
+    return bytes.first[0];
+  }
+
+  bool isSmallerSuffix(uint64_t const i, uint64_t const j) const {
+    uint64_t const lce_s = lce(i, j);
+    // Suffix j is a prefix of suffix i (or i == j)
+    if (TLX_UNLIKELY(j + lce_s >= size())) {
+      return false;
+    }
+    if (TLX_UNLIKELY(i + lce_s >= size())) {
+      return true;
+    }
+    return static_cast<uint8_t>((*this)[i + lce_s]) < static_cast<uint8_t>((*this)[j + lce_s]);
+  }
+
+  size_t getSizeInBytes() const {
+    return memory_breakdown().total();
+  }
+
+  /* The parts include their text. While a merge is running, its copy of the
+     merged text and of the indexed part of the buffer is reported as well. */
+  lce_test::memory_report memory_breakdown() const {
+    lce_test::memory_report report;
+    for (size_t k = 0; k < parts_.size(); ++k) {
+      report.add("part" + std::to_string(k), parts_[k]->lce.memory_breakdown());
+    }
+    report.add("buffer", lce_test::bytes_of(buffer_));
+    report.add("fingerprints", lce_test::bytes_of(fingerprints_));
+    if (rebuilding()) {
+      lce_test::memory_report merge;
+      merge.add("text", merge_text_bytes_);
+      merge.add("buffer", merge_buffer_bytes_);
+      report.add("merge", merge);
+    }
+    return report;
+  }
+
+  /* Construction phases of the first (i.e., largest) part */
+  lce_test::phase_profiler const& getPhaseProfile() const {
+    static lce_test::phase_profiler const no_phases;
+    return parts_.empty() ? no_phases : parts_.front()->lce.getPhaseProfile();
+  }
+
+ private:
+  /* Immutable index over a copy of T[begin, begin + m) */
+  struct part {
+    part(std::vector<uint8_t> v_text, sss_ranking const ranking)
+        : text(std::move(v_text)), lce(text, false, ranking) {}
+
+    part(std::vector<uint8_t> v_text, part const& prefix)
+        : text(std::move(v_text)), lce(text, prefix.lce) {}
+
+    std::vector<uint8_t> const text;
+    LceSemiSyncSetsPar<kTau> const lce;
+  };
+
+  /* Merges the buffer (rounded down to kFingerprintSample) with the last
+     parts that are at most twice as long as the merged text in the
+     background. If force is set, the buffer is also merged if it is short,
+     together with the last parts up to min_index_size characters. Returns
+     whether a merge was started. */
+  bool start_rebuild(bool const force) {
+    uint64_t const buffer_length = buffer_.size() / kFingerprintSample * kFingerprintSample;
+    uint64_t length = buffer_length;
+    size_t first = parts_.size();
+    while (first > 0 && (parts_[first - 1]->text.size() <= 2 * length ||
+                         (force && length < min_index_size_))) {
+      --first;
+      length += parts_[first]->text.size();
+    }
+    if (buffer_length == 0 || length < min_index_size_) {
+      return false;
+    }
+    std::vector<std::shared_ptr<part const>> merged(parts_.begin() + first, parts_.end());
+    std::vector<uint8_t> buffer(buffer_.begin(), buffer_.begin() + buffer_length);
+    merge_first_ = first;
+    merge_text_bytes_ = length;
+    merge_buffer_bytes_ = buffer_length;
+    pending_ = std::async(std::launch::async,
+                          [merged = std::move(merged), buffer = std::move(buffer), length,
+                           ranking = ranking_]() mutable {
+      if (merged.empty()) {
+        return std::make_shared<part const>(std::move(buffer), ranking);
+      }
+      std::vector<uint8_t> text;
+      text.reserve(length);
+      for (auto const& p : merged) {
+        text.insert(text.end(), p->text.begin(), p->text.end());
+      }
+      text.insert(text.end(), buffer.begin(), buffer.end());
+      return std::make_shared<part const>(std::move(text), *merged.front());
+    });
+    return true;
+  }
+
+  /* Replaces the merged parts by the new one, and removes its characters
+     from the buffer */
+  void install(std::shared_ptr<part const> next) {
+    uint64_t const begin = (merge_first_ < parts_.size()) ? begins_[merge_first_] : indexed_size();
+    uint64_t const indexed_by_next = begin + next->text.size() - indexed_size();
+    buffer_.erase(buffer_.begin(), buffer_.begin() + indexed_by_next);
+    parts_.resize(merge_first_);
+    begins_.resize(merge_first_);
+    parts_.push_back(std::move(next));
+    begins_.push_back(begin);
+  }
+
+  /* Index of the part containing T[i] for i < indexed_size() */
+  size_t part_of(uint64_t const i) const {
+    return std::upper_bound(begins_.begin(), begins_.end(), i) - begins_.begin() - 1;
+  }
+
+  /* Pointer to T[i] and the number of characters stored contiguously from
+     there */
+  std::pair<uint8_t const*, uint64_t> bytes_from(uint64_t const i) const {
+    if (i >= indexed_size()) {
+      return {buffer_.data() + (i - indexed_size()), size() - i};
+    }
+    size_t const k = part_of(i);
+    return {parts_[k]->text.data() + (i - begins_[k]), begins_[k] + parts_[k]->text.size() - i};
+  }
+
+  /* Compares T[i, i + max_length) and T[j, j + max_length) piece by piece,
+     since both may reach over the end of a part */
+  uint64_t lce_in_text(uint64_t const i, uint64_t const j, uint64_t const max_length) const {
+    uint64_t lce = 0;
+    while (lce < max_length) {
+      auto const [a, a_size] = bytes_from(i + lce);
+      auto const [b, b_size] = bytes_from(j + lce);
+      uint64_t const piece = std::min({a_size, b_size, max_length - lce});
+      uint64_t const piece_lce = lce_test::naive_lce(a, b, piece);
+      lce += piece_lce;
+      if (piece_lce < piece) {
+        break;
+      }
+    }
+    return lce;
+  }
+
+  /* Returns min(lce(i, j), max_length) by scanning up to kNaiveScan
+     characters, and by an exponential and a binary search on the
+     fingerprints afterwards (as in LcePrezza) */
+  uint64_t fingerprint_lce(uint64_t const i, uint64_t const j, uint64_t const max_length) const {
+    uint64_t add = lce_in_text(i, j, std::min(max_length, kNaiveScan));
+    if (add < kNaiveScan || add == max_length) {
+      return add;
+    }
+    // T[i, i + add) = T[j, j + add), and to_i and to_j are the fingerprints
+    // of T[0, i + add) and T[0, j + add)
+    int exp = std::countr_zero(add);
+    uint64_t to_i = fingerprint_to(i + add);
+    uint64_t to_j = fingerprint_to(j + add);
+    auto const matches = [&](uint64_t const end_i, uint64_t const end_j) {
+      uint64_t const shift = powers_[exp];
+      return submod(end_i, fingerprint_.reduce(uint128_t{to_i} * shift)) ==
+             submod(end_j, fingerprint_.reduce(uint128_t{to_j} * shift));
+    };
+    while (2 * add <= max_length) {
+      uint64_t const end_i = fingerprint_to(i + 2 * add);
+      uint64_t const end_j = fingerprint_to(j + 2 * add);
+      if (!matches(end_i, end_j)) {
+        break;
+      }
+      to_i = end_i;
+      to_j = end_j;
+      add *= 2;
+      ++exp;
+    }
+    uint64_t dist = add;
+    while (dist > kNaiveScan) {
+      --exp;
+      dist /= 2;
+      if (add + dist <= max_length) {
+        uint64_t const end_i = fingerprint_to(i + add + dist);
+        uint64_t const end_j = fingerprint_to(j + add + dist);
+        if (matches(end_i, end_j)) {
+          to_i = end_i;
+          to_j = end_j;
+          add += dist;
+        }
+      }
+    }
+    return add + lce_in_text(i + add, j + add, max_length - add);
+  }
+
+  /* Fingerprint of T[0, x), extended from the last sample */
+  uint64_t fingerprint_to(uint64_t const x) const {
+    uint64_t const sample = x / kFingerprintSample;
+    uint64_t const begin = sample * kFingerprintSample;
+    return extend(fingerprints_[sample], bytes_from(begin).first, x - begin);
+  }
+
+  /* Fingerprint of the text with fingerprint fingerprint followed by
+     bytes[0, length), 8 characters at a time */
+  uint64_t extend(uint64_t fingerprint, uint8_t const* const bytes, uint64_t const length) const {
+    uint64_t k = 0;
+    for (; k + 8 <= length; k += 8) {
+      uint64_t block;
+      std::memcpy(&block, bytes + k, sizeof(block));
+      if constexpr (std::endian::native == std::endian::little) {
+        block = __builtin_bswap64(block);
+      }
+      fingerprint = fingerprint_.reduce((uint128_t{fingerprint} << 64) + block);
+    }
+    if (k < length) {
+      uint64_t block = 0;
+      for (; k < length; ++k) {
+        block = (block << 8) | bytes[k];
+      }
+      fingerprint = fingerprint_.reduce((uint128_t{fingerprint} << (8 * (length % 8))) + block);
+    }
+    return fingerprint;
+  }
+
+  uint64_t submod(uint64_t const a, uint64_t const b) const {
+    return a >= b ? a - b : fingerprint_.prime() - (b - a);
+  }
+
+  sss_ranking const ranking_;
+  uint64_t const min_index_size_;
+
+  lce_test::fingerprint_montgomery const fingerprint_;
+  std::array<uint64_t, 70> const powers_;
+  // fingerprints_[k] is the fingerprint of T[0, k * kFingerprintSample)
+  std::vector<uint64_t> fingerprints_;
+  // Fingerprint of the whole text
+  uint64_t fingerprint_end_ = 0;
+
+  // parts_[k] indexes T[begins_[k], begins_[k + 1])
+  std::vector<std::shared_ptr<part const>> parts_;
+  std::vector<uint64_t> begins_;
+  std::vector<uint8_t> buffer_;
+
+  // The running merge replaces the parts from merge_first_ on
+  std::future<std::shared_ptr<part const>> pending_;
+  size_t merge_first_ = 0;
+  uint64_t merge_text_bytes_ = 0;
+  uint64_t merge_buffer_bytes_ = 0;
+};
+}  // namespace lce_test::par
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+
+namespace lce_test {
+
+/* Modular arithmetic of the Karp-Rabin fingerprints of LcePrezza. A policy
+ * provides prime() and reduce(x) = x mod prime() for x < prime() * 2^64.
+ *
+ * LcePrezza overwrites each block of 8 characters with a fingerprint and
+ * stores in the highest bit whether the block was larger than the prime, so
+ * the prime must be slightly larger than 2^63. This rules out Mersenne primes
+ * such as 2^61 - 1, but primes 2^63 + c with small c are pseudo-Mersenne:
+ * 2^64 = -2c (mod 2^63 + c). */
+
+/* Reduces with the generic 128-bit division */
+template <uint64_t t_prime = 0x800000000000001dULL>
+struct fingerprint_division {
+  __extension__ typedef unsigned __int128 uint128_t;
+
+  static constexpr uint64_t prime() {
+    return t_prime;
+  }
+
+  static constexpr uint64_t reduce(uint128_t const x) {
+    return static_cast<uint64_t>(x % t_prime);
+  }
+};
+
+/* Reduces modulo 2^63 + c by folding the upper 64 bits twice, using
+   2^64 = -2c, i.e., with multiplications by a small constant instead of a
+   division. */
+template <uint64_t t_prime = 0x800000000000001dULL>
+struct fingerprint_pseudo_mersenne {
+  __extension__ typedef unsigned __int128 uint128_t;
+
+  static_assert(t_prime > (uint64_t{1} << 63) && t_prime - (uint64_t{1} << 63) < (uint64_t{1} << 16),
+                "The prime must be 2^63 + c with a small c");
+  static constexpr uint64_t kFold = 2 * (t_prime - (uint64_t{1} << 63));
+
+  static constexpr uint64_t prime() {
+    return t_prime;
+  }
+
+  static constexpr uint64_t reduce(uint128_t const x) {
+    // x = lo - kFold * hi = lo - b + kFold * a with kFold * hi = a * 2^64 + b
+    uint128_t const folded = (x >> 64) * kFold;
+    uint64_t r;
+    bool const borrow = __builtin_sub_overflow(static_cast<uint64_t>(x),
+                                               static_cast<uint64_t>(folded), &r);
+    uint64_t const a = static_cast<uint64_t>(folded >> 64) + borrow;
+    if (__builtin_add_overflow(r, a * kFold, &r)) {
+      r += t_prime - kFold;  // 2^64 mod prime, r is small here
+    }
+    return r >= t_prime ? r - t_prime : r;
+  }
+};
+
+/* Reduces modulo any odd prime with two Montgomery reductions, i.e., with
+   four 64-bit multiplications. By default, the prime is drawn at random from
+   (2^63, 2^63 + 2^24), so two different strings of length l have the same
+   fingerprint with probability at most about 8l / (63 * 380000), independent
+   of the text (there are about 380000 primes in the range, and the difference
+   of the strings has at most 8l / 63 of them as factors). Fingerprints in
+   [2^63, prime) do not fit next to the helping bit of LcePrezza, which keeps
+   their highest bit in a separate list. */
+class fingerprint_montgomery {
+public:
+  __extension__ typedef unsigned __int128 uint128_t;
+
+  fingerprint_montgomery() : fingerprint_montgomery(random_prime()) {}
+
+  explicit fingerprint_montgomery(uint64_t const prime) : prime_(prime) {
+    // Newton's iteration doubles the number of correct low bits
+    uint64_t inverse = prime;
+    for (size_t i = 0; i < 5; ++i) {
+      inverse *= 2 - prime * inverse;
+    }
+    neg_inverse_ = -inverse;
+    uint64_t const r = static_cast<uint64_t>((uint128_t{1} << 64) % prime);
+    r_squared_ = static_cast<uint64_t>((uint128_t{r} * r) % prime);
+  }
+
+  uint64_t prime() const {
+    return prime_;
+  }
+
+  uint64_t reduce(uint128_t const x) const {
+    return redc(uint128_t{redc(x)} * r_squared_);
+  }
+
+  /* A random prime in (2^63, 2^63 + 2^24) */
+  static uint64_t random_prime() {
+    std::mt19937_64 gen{std::random_device{}()};
+    uint64_t candidate = ((uint64_t{1} << 63) + (gen() & ((uint64_t{1} << 24) - 1))) | 1;
+    while (!is_prime(candidate)) {
+      candidate += 2;
+    }
+    return candidate;
+  }
+
+  /* Deterministic Miller-Rabin test for 64-bit integers */
+  static bool is_prime(uint64_t const n) {
+    if (n < 2) {
+      return false;
+    }
+    for (uint64_t const p : {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37}) {
+      if (n % p == 0) {
+        return n == p;
+      }
+    }
+    uint64_t d = n - 1;
+    int s = 0;
+    while (d % 2 == 0) {
+      d /= 2;
+      ++s;
+    }
+    for (uint64_t const a : {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37}) {
+      uint64_t x = pow_mod(a, d, n);
+      if (x == 1 || x == n - 1) {
+        continue;
+      }
+      bool composite = true;
+      for (int r = 1; r < s && composite; ++r) {
+        x = static_cast<uint64_t>((uint128_t{x} * x) % n);
+        composite = (x != n - 1);
+      }
+      if (composite) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+private:
+  uint64_t prime_;
+  uint64_t neg_inverse_;  // -prime^-1 mod 2^64
+  uint64_t r_squared_;    // 2^128 mod prime
+
+  /* x * 2^-64 mod prime for x < prime * 2^64 */
+  uint64_t redc(uint128_t const x) const {
+    uint64_t const m = static_cast<uint64_t>(x) * neg_inverse_;
+    // The low halves of x and m * prime add up to 0 mod 2^64, with a carry
+    // unless both are 0
+    uint128_t const t = (x >> 64) + ((uint128_t{m} * prime_) >> 64) +
+                        (static_cast<uint64_t>(x) != 0);
+    return static_cast<uint64_t>(t >= prime_ ? t - prime_ : t);
+  }
+
+  static uint64_t pow_mod(uint64_t base, uint64_t exp, uint64_t const mod) {
+    uint64_t result = 1;
+    base %= mod;
+    while (exp > 0) {
+      if (exp & 1) {
+        result = static_cast<uint64_t>((uint128_t{result} * base) % mod);
+      }
+      base = static_cast<uint64_t>((uint128_t{base} * base) % mod);
+      exp >>= 1;
+    }
+    return result;
+  }
+};
+
+} // namespace lce_test
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <sys/mman.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <string>
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+#ifndef MAP_HUGE_1GB
+#define MAP_HUGE_1GB (30 << MAP_HUGE_SHIFT)
+#endif
+
+namespace lce_test {
+
+/* How large arrays are backed by pages:
+ * off:  default pages (malloc)
+ * thp:  transparent huge pages (2 MiB aligned mmap + MADV_HUGEPAGE)
+ * 2m:   reserved 2 MiB huge pages (MAP_HUGETLB), falling back to thp
+ * 1g:   reserved 1 GiB huge pages for arrays of at least 1 GiB, falling back
+ *       to 2m (and thp) */
+enum class huge_page_mode { off, thp, hugetlb_2m, hugetlb_1g };
+
+constexpr size_t huge_page_size_2m = size_t{1} << 21;
+constexpr size_t huge_page_size_1g = size_t{1} << 30;
+
+inline huge_page_mode& global_huge_page_mode() {
+  static huge_page_mode mode = huge_page_mode::off;
+  return mode;
+}
+
+/* Sets the mode of all allocators that are created afterwards. */
+inline void set_huge_page_mode(huge_page_mode const mode) {
+  global_huge_page_mode() = mode;
+}
+
+/* Parses "off", "thp", "2m" or "1g". Returns false for other strings. */
+inline bool parse_huge_page_mode(std::string const& name, huge_page_mode& mode) {
+  if (name == "off") {
+    mode = huge_page_mode::off;
+  } else if (name == "thp") {
+    mode = huge_page_mode::thp;
+  } else if (name == "2m") {
+    mode = huge_page_mode::hugetlb_2m;
+  } else if (name == "1g") {
+    mode = huge_page_mode::hugetlb_1g;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+inline std::string to_string(huge_page_mode const mode) {
+  switch (mode) {
+    case huge_page_mode::thp: return "thp";
+    case huge_page_mode::hugetlb_2m: return "2m";
+    case huge_page_mode::hugetlb_1g: return "1g";
+    default: return "off";
+  }
+}
+
+/* Smaller arrays are allocated using operator new. */
+inline bool use_huge_pages(huge_page_mode const mode, size_t const bytes) {
+  return mode != huge_page_mode::off && bytes >= huge_page_size_2m;
+}
+
+/* Size of the mapping of a huge page allocation. It does not depend on the
+ * kind of pages we actually got, so it is also known when freeing. */
+inline size_t huge_page_mapping_size(huge_page_mode const mode,
+                                     size_t const bytes) {
+  size_t const page_size =
+      (mode == huge_page_mode::hugetlb_1g && bytes >= huge_page_size_1g)
+          ? huge_page_size_1g
+          : huge_page_size_2m;
+  return (bytes + page_size - 1) / page_size * page_size;
+}
+
+/* Marks all huge pages completely contained in [ptr, ptr + bytes) for
+ * transparent huge pages. Only pages that have not been touched yet are
+ * backed by huge pages directly, all others are collapsed by khugepaged. */
+inline void advise_huge_pages([[maybe_unused]] void* const ptr,
+                              [[maybe_unused]] size_t const bytes) {
+#ifdef MADV_HUGEPAGE
+  uintptr_t const begin = (reinterpret_cast<uintptr_t>(ptr) +
+                           huge_page_size_2m - 1) & ~(huge_page_size_2m - 1);
+  uintptr_t const end =
+      (reinterpret_cast<uintptr_t>(ptr) + bytes) & ~(huge_page_size_2m - 1);
+  if (begin < end) {
+    madvise(reinterpret_cast<void*>(begin), end - begin, MADV_HUGEPAGE);
+  }
+#endif
+}
+
+/* Allocates memory backed by huge pages. Requires use_huge_pages(mode, bytes).
+ * Falls back to smaller (and finally transparent) huge pages. */
+inline void* allocate_huge_pages(huge_page_mode const mode, size_t const bytes) {
+  size_t const size = huge_page_mapping_size(mode, bytes);
+  int const flags = MAP_PRIVATE | MAP_ANONYMOUS;
+  void* ptr = MAP_FAILED;
+  if (mode == huge_page_mode::hugetlb_1g && size % huge_page_size_1g == 0) {
+    ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+               flags | MAP_HUGETLB | MAP_HUGE_1GB, -1, 0);
+  }
+  if (ptr == MAP_FAILED && mode != huge_page_mode::thp) {
+    ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+               flags | MAP_HUGETLB | MAP_HUGE_2MB, -1, 0);
+  }
+  if (ptr != MAP_FAILED) {
+    return ptr;
+  }
+
+  // Transparent huge pages need 2 MiB aligned memory, so we map a larger
+  // area and unmap the unaligned head and tail.
+  size_t const padded_size = size + huge_page_size_2m;
+  void* const area = mmap(nullptr, padded_size, PROT_READ | PROT_WRITE,
+                          flags, -1, 0);
+  if (area == MAP_FAILED) {
+    throw std::bad_alloc();
+  }
+  uintptr_t const area_begin = reinterpret_cast<uintptr_t>(area);
+  uintptr_t const begin = (area_begin + huge_page_size_2m - 1) &
+                          ~(huge_page_size_2m - 1);
+  if (begin > area_begin) {
+    munmap(area, begin - area_begin);
+  }
+  size_t const tail = area_begin + padded_size - (begin + size);
+  if (tail > 0) {
+    munmap(reinterpret_cast<void*>(begin + size), tail);
+  }
+  ptr = reinterpret_cast<void*>(begin);
+  advise_huge_pages(ptr, size);
+  return ptr;
+}
+
+inline void free_huge_pages(huge_page_mode const mode, void* const ptr,
+                            size_t const bytes) {
+  munmap(ptr, huge_page_mapping_size(mode, bytes));
+}
+
+} // namespace lce_test
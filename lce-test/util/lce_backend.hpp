@@ -0,0 +1,103 @@
+#pragma once
+
+#include <concepts>
+#include <cstdint>
+#include <span>
+
+#include "util/memory_report.hpp"
+#include "util/phase_profiler.hpp"
+
+namespace lce_test {
+
+/* Requirements on an LCE data structure. Algorithms that are templated on the
+ * data structure call it without virtual dispatch, so short queries (e.g. the
+ * naive part of the string synchronizing sets) can be inlined. For runtime
+ * polymorphism, wrap the data structure in an LceAdapter (lce_interface.hpp).
+ *
+ * - lce(i, j): length of the longest common prefix of suffixes i and j
+ * - lce_bounded(i, j, cap): min(lce(i, j), cap), which may be much faster
+ *   for small caps
+ * - ds[i]: character at position i
+ * - isSmallerSuffix(i, j): whether suffix i is lexicographically smaller */
+template <typename T>
+concept LceBackend = requires(T& ds, T const& const_ds, uint64_t const i,
+                              uint64_t const j) {
+  { ds.lce(i, j) } -> std::convertible_to<uint64_t>;
+  { ds.lce_bounded(i, j, i) } -> std::convertible_to<uint64_t>;
+  { ds[i] } -> std::convertible_to<char>;
+  { ds.isSmallerSuffix(i, j) } -> std::convertible_to<bool>;
+  { ds.getSizeInBytes() } -> std::convertible_to<uint64_t>;
+  { const_ds.memory_breakdown() } -> std::same_as<memory_report>;
+};
+
+/* Backends that answer many queries at once (e.g. to overlap cache misses)
+ * provide lce_batch(indices, results), where the k-th query is
+ * (indices[2k], indices[2k + 1]). */
+template <typename T>
+concept LceBatchBackend = LceBackend<T> &&
+    requires(T& ds, std::span<uint64_t const> const indices,
+             std::span<uint64_t> const results) {
+  ds.lce_batch(indices, results);
+};
+
+/* Backends that also answer backward LCE queries, i.e., the length of the
+ * longest common suffix of T[0, i] and T[0, j]. */
+template <typename T>
+concept LceBackwardBackend = LceBackend<T> &&
+    requires(T& ds, uint64_t const i, uint64_t const j) {
+  { ds.lce_backward(i, j) } -> std::convertible_to<uint64_t>;
+  { ds.lce_backward_bounded(i, j, i) } -> std::convertible_to<uint64_t>;
+};
+
+/* Answers the queries (indices[2k], indices[2k + 1]) and stores the k-th
+ * result in results[k]. */
+template <LceBackend backend_type>
+inline void lce_batch(backend_type& ds, std::span<uint64_t const> const indices,
+                      std::span<uint64_t> const results) {
+  if constexpr (LceBatchBackend<backend_type>) {
+    ds.lce_batch(indices, results);
+  } else {
+    for (size_t k = 0; k < results.size(); ++k) {
+      results[k] = ds.lce(indices[2 * k], indices[2 * k + 1]);
+    }
+  }
+}
+
+/* Strict weak ordering of the suffixes of a text of length text_size, e.g.,
+ * for sparse suffix sorting with std::sort. Unlike isSmallerSuffix, it does
+ * not depend on a sentinel at the end of the text. */
+template <LceBackend backend_type>
+class suffix_comparator {
+public:
+  suffix_comparator(backend_type& ds, uint64_t const text_size)
+      : ds_(&ds), text_size_(text_size) {}
+
+  inline bool operator()(uint64_t const i, uint64_t const j) const {
+    uint64_t const lce = ds_->lce(i, j);
+    if (j + lce >= text_size_) [[unlikely]] {
+      return false;  // Suffix j is a prefix of suffix i (or i == j)
+    }
+    if (i + lce >= text_size_) [[unlikely]] {
+      return true;
+    }
+    return static_cast<uint8_t>((*ds_)[i + lce]) <
+           static_cast<uint8_t>((*ds_)[j + lce]);
+  }
+
+private:
+  backend_type* ds_;
+  uint64_t text_size_;
+};
+
+/* Construction phases of the backend (empty if it does not report any). */
+template <LceBackend backend_type>
+inline phase_profiler const& phase_profile_of(backend_type const& ds) {
+  if constexpr (requires { { ds.getPhaseProfile() } -> std::same_as<phase_profiler const&>; }) {
+    return ds.getPhaseProfile();
+  } else {
+    static phase_profiler const no_phases;
+    return no_phases;
+  }
+}
+
+} // namespace lce_test
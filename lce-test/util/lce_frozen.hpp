@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "util/lce_backend.hpp"
+#include "util/memory_report.hpp"
+
+namespace lce_test {
+
+/* Backends whose queries can be answered through a const reference. All
+ * backends of this repository are reentrant in this case, i.e., concurrent
+ * const queries from multiple threads are safe as long as nobody modifies the
+ * data structure (or the text it refers to) at the same time. */
+template <typename T>
+concept ConstLceBackend = LceBackend<T> &&
+    requires(T const& ds, uint64_t const i, uint64_t const j) {
+  { ds.lce(i, j) } -> std::convertible_to<uint64_t>;
+  { ds.lce_bounded(i, j, i) } -> std::convertible_to<uint64_t>;
+  { ds[i] } -> std::convertible_to<char>;
+  { ds.isSmallerSuffix(i, j) } -> std::convertible_to<bool>;
+  { ds.getSizeInBytes() } -> std::convertible_to<uint64_t>;
+};
+
+/* Shared read-only handle of a constructed LCE data structure. Copies of the
+ * handle refer to the same data structure, so all threads can query a single
+ * instance (e.g. one in-place LcePrezza) instead of building one per thread.
+ * The data structure is destroyed when the last handle is gone.
+ *
+ * Freezing does not copy anything. In particular, in-place data structures
+ * still refer to the (overwritten) text, which must neither be modified nor
+ * retransformed while a handle exists. */
+template <ConstLceBackend backend_type>
+class frozen_lce {
+public:
+  explicit frozen_lce(std::shared_ptr<backend_type const> ds)
+      : ds_(std::move(ds)) {}
+
+  inline uint64_t lce(uint64_t const i, uint64_t const j) const {
+    return ds_->lce(i, j);
+  }
+
+  inline uint64_t lce_bounded(uint64_t const i, uint64_t const j,
+                              uint64_t const cap) const {
+    return ds_->lce_bounded(i, j, cap);
+  }
+
+  inline uint64_t lce_backward(uint64_t const i, uint64_t const j) const
+      requires LceBackwardBackend<backend_type> {
+    return ds_->lce_backward(i, j);
+  }
+
+  inline uint64_t lce_backward_bounded(uint64_t const i, uint64_t const j,
+                                       uint64_t const cap) const
+      requires LceBackwardBackend<backend_type> {
+    return ds_->lce_backward_bounded(i, j, cap);
+  }
+
+  inline char operator[](uint64_t const i) const {
+    return (*ds_)[i];
+  }
+
+  inline bool isSmallerSuffix(uint64_t const i, uint64_t const j) const {
+    return ds_->isSmallerSuffix(i, j);
+  }
+
+  uint64_t getSizeInBytes() const {
+    return ds_->getSizeInBytes();
+  }
+
+  memory_report memory_breakdown() const {
+    return ds_->memory_breakdown();
+  }
+
+  backend_type const& get() const {
+    return *ds_;
+  }
+
+  /* Number of handles sharing the data structure. */
+  long use_count() const {
+    return ds_.use_count();
+  }
+
+private:
+  std::shared_ptr<backend_type const> ds_;
+}; // class frozen_lce
+
+/* Takes ownership of the data structure and returns the first handle. */
+template <ConstLceBackend backend_type>
+frozen_lce<backend_type> freeze(std::unique_ptr<backend_type> ds) {
+  return frozen_lce<backend_type>(std::shared_ptr<backend_type const>(std::move(ds)));
+}
+
+} // namespace lce_test
@@ -9,17 +9,80 @@
 #pragma once
 
 #include <cstdint>
+#include <utility>
 
+#include "util/lce_backend.hpp"
+#include "util/memory_report.hpp"
+#include "util/phase_profiler.hpp"
+
+/* Runtime-polymorphic interface of the LCE data structures. The data
+   structures themselves do not derive from it (see lce_test::LceBackend);
+   use LceAdapter to obtain an LceDataStructure. */
 class LceDataStructure {
 public:
   virtual ~LceDataStructure() = 0;
   virtual uint64_t lce(const uint64_t i, const uint64_t j) = 0;
+  /* min(lce(i, j), cap) */
+  virtual uint64_t lce_bounded(const uint64_t i, const uint64_t j,
+                               const uint64_t cap) = 0;
   //virtual char getChar(const uint64_t i) = 0;
   virtual char operator[](const uint64_t i) = 0;
   virtual int isSmallerSuffix(const uint64_t i, const uint64_t j) = 0;
   virtual uint64_t getSizeInBytes() = 0;
+  /* Space of all components of the data structure (including the text). */
+  virtual lce_test::memory_report memory_breakdown() const = 0;
+  /* Timings and memory of the construction phases (empty if the data
+     structure does not report phases). */
+  virtual lce_test::phase_profiler const& getPhaseProfile() const {
+    static lce_test::phase_profiler const no_phases;
+    return no_phases;
+  }
 }; // class LceDataStructure
 
 LceDataStructure::~LceDataStructure() { }
 
+/* Owns an LCE data structure and forwards the virtual calls to it. */
+template <lce_test::LceBackend backend_type>
+class LceAdapter final : public LceDataStructure {
+public:
+  template <typename... Args>
+  explicit LceAdapter(Args&&... args) : backend_(std::forward<Args>(args)...) {}
+
+  uint64_t lce(const uint64_t i, const uint64_t j) override {
+    return backend_.lce(i, j);
+  }
+
+  uint64_t lce_bounded(const uint64_t i, const uint64_t j,
+                       const uint64_t cap) override {
+    return backend_.lce_bounded(i, j, cap);
+  }
+
+  char operator[](const uint64_t i) override {
+    return backend_[i];
+  }
+
+  int isSmallerSuffix(const uint64_t i, const uint64_t j) override {
+    return backend_.isSmallerSuffix(i, j);
+  }
+
+  uint64_t getSizeInBytes() override {
+    return backend_.getSizeInBytes();
+  }
+
+  lce_test::memory_report memory_breakdown() const override {
+    return backend_.memory_breakdown();
+  }
+
+  lce_test::phase_profiler const& getPhaseProfile() const override {
+    return lce_test::phase_profile_of(backend_);
+  }
+
+  backend_type& backend() {
+    return backend_;
+  }
+
+private:
+  backend_type backend_;
+}; // class LceAdapter
+
 /******************************************************************************/
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace lce_test {
+
+/* Number of bytes allocated by a std::vector-like container. */
+template <typename vector_type>
+uint64_t bytes_of(vector_type const& v) {
+  return v.capacity() * sizeof(typename vector_type::value_type);
+}
+
+struct memory_component {
+  std::string name;
+  uint64_t bytes;
+};
+
+/* Space (in bytes) of all components of a data structure. This does not rely
+ * on malloc_count, so it also works in parallel builds. */
+class memory_report {
+public:
+  memory_report& add(std::string name, uint64_t const bytes) {
+    components_.push_back({std::move(name), bytes});
+    return *this;
+  }
+
+  /* Adds all components of a sub-structure as "<prefix>_<component>". */
+  memory_report& add(std::string const& prefix, memory_report const& other) {
+    for (auto const& component : other.components_) {
+      components_.push_back({prefix + "_" + component.name, component.bytes});
+    }
+    return *this;
+  }
+
+  uint64_t total() const {
+    uint64_t sum = 0;
+    for (auto const& component : components_) {
+      sum += component.bytes;
+    }
+    return sum;
+  }
+
+  /* Returns the size of the component or 0 if it does not exist. */
+  uint64_t operator[](std::string const& name) const {
+    for (auto const& component : components_) {
+      if (component.name == name) {
+        return component.bytes;
+      }
+    }
+    return 0;
+  }
+
+  std::vector<memory_component> const& components() const {
+    return components_;
+  }
+
+  /* Prints all components in the RESULT format of our benchmarks, i.e.,
+   * "mem_<component>=... " */
+  friend std::ostream& operator<<(std::ostream& os, memory_report const& r) {
+    for (auto const& component : r.components_) {
+      os << "mem_" << component.name << "=" << component.bytes << " ";
+    }
+    return os;
+  }
+
+private:
+  std::vector<memory_component> components_;
+}; // class memory_report
+
+} // namespace lce_test
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+namespace lce_test {
+
+/* Returns the length of the longest common prefix of a[0, max_length) and
+ * b[0, max_length). The strings may be parts of different arrays. */
+inline uint64_t naive_lce(uint8_t const* const a, uint8_t const* const b,
+                          uint64_t const max_length) {
+  __extension__ typedef unsigned __int128 uint128_t;
+
+  uint64_t lce = 0;
+  // First we compare the first few characters. We do this, because in the
+  // usual case the lce is low.
+  for (; lce < 8; ++lce) {
+    if (lce >= max_length) [[unlikely]] {
+      return max_length;
+    }
+    if (a[lce] != b[lce]) {
+      return lce;
+    }
+  }
+
+  // Accelerate search by comparing 16-byte blocks
+  lce = 0;
+  uint128_t const* const blocks_a = reinterpret_cast<uint128_t const*>(a);
+  uint128_t const* const blocks_b = reinterpret_cast<uint128_t const*>(b);
+  for (; lce < max_length / 16; ++lce) {
+    if (blocks_a[lce] != blocks_b[lce]) {
+      break;
+    }
+  }
+  lce *= 16;
+  // The last block did not match (or is incomplete). Here we compare its
+  // single characters
+  uint64_t const lce_end = std::min(lce + 16, max_length);
+  for (; lce < lce_end; ++lce) {
+    if (a[lce] != b[lce]) {
+      break;
+    }
+  }
+  return lce;
+}
+
+/* Returns min(LCE(i, j), max_length) by comparing the text directly. Both
+ * i + max_length and j + max_length must not exceed the length of the text. */
+inline uint64_t naive_lce(uint8_t const* const text, uint64_t const i,
+                          uint64_t const j, uint64_t const max_length) {
+  return naive_lce(text + i, text + j, max_length);
+}
+
+/* Returns min(LCS(i, j), max_length), where LCS(i, j) is the length of the
+ * longest common suffix of text[0, i] and text[0, j]. max_length must not
+ * exceed min(i, j) + 1. */
+inline uint64_t naive_lce_backward(uint8_t const* const text, uint64_t const i,
+                                   uint64_t const j,
+                                   uint64_t const max_length) {
+  __extension__ typedef unsigned __int128 uint128_t;
+
+  uint64_t lcs = 0;
+  for (; lcs < 8; ++lcs) {
+    if (lcs >= max_length) [[unlikely]] {
+      return max_length;
+    }
+    if (text[i - lcs] != text[j - lcs]) {
+      return lcs;
+    }
+  }
+
+  // Compare the 16-byte blocks ending at i - lcs and j - lcs
+  lcs = 0;
+  for (; lcs + 16 <= max_length; lcs += 16) {
+    if (*reinterpret_cast<uint128_t const*>(text + i - lcs - 15) !=
+        *reinterpret_cast<uint128_t const*>(text + j - lcs - 15)) {
+      break;
+    }
+  }
+  uint64_t const lcs_end = std::min(lcs + 16, max_length);
+  for (; lcs < lcs_end; ++lcs) {
+    if (text[i - lcs] != text[j - lcs]) {
+      break;
+    }
+  }
+  return lcs;
+}
+
+} // namespace lce_test
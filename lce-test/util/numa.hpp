@@ -0,0 +1,193 @@
+#pragma once
+
+#include <sched.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifdef LCE_NUMA
+#include <numa.h>
+#endif
+
+#include "huge_pages.hpp"
+
+namespace lce_test {
+
+/* Number of NUMA nodes of the machine. Without libnuma (LCE_NUMA), we assume
+ * a single node. */
+inline int numa_num_nodes() {
+#ifdef LCE_NUMA
+  static int const num_nodes =
+      (numa_available() < 0) ? 1 : numa_num_configured_nodes();
+  return num_nodes;
+#else
+  return 1;
+#endif
+}
+
+/* NUMA node of the CPU the calling thread is running on. */
+inline int numa_current_node() {
+#ifdef LCE_NUMA
+  if (numa_num_nodes() > 1) {
+    int const cpu = sched_getcpu();
+    int const node = (cpu < 0) ? 0 : numa_node_of_cpu(cpu);
+    return (node < 0) ? 0 : node;
+  }
+#endif
+  return 0;
+}
+
+/* Node of allocators whose pages are interleaved over all nodes */
+constexpr int numa_interleaved = -2;
+
+/* Allocator that does not initialize trivial elements on resize. Thus, pages
+ * are not touched by the thread resizing the vector, but by the first thread
+ * writing to them, which (on Linux) places them on that thread's node. If a
+ * node is given (and libnuma is available), the memory is bound to that node
+ * instead, or interleaved over all nodes for numa_interleaved. Large arrays
+ * are backed by huge pages according to the huge page mode at the time the
+ * allocator is created (see set_huge_page_mode). */
+template <typename T>
+class numa_allocator {
+public:
+  using value_type = T;
+  using propagate_on_container_move_assignment = std::true_type;
+
+  numa_allocator() = default;
+  explicit numa_allocator(int const node) : node_(node) {}
+  numa_allocator(int const node, huge_page_mode const huge_pages)
+      : node_(node), huge_pages_(huge_pages) {}
+  template <typename U>
+  numa_allocator(numa_allocator<U> const& other)
+      : node_(other.node()), huge_pages_(other.huge_pages()) {}
+
+  /* The placement policy (mbind) is only applied to page-aligned memory,
+     i.e., to huge page mappings and memory from libnuma, which maps whole
+     pages. */
+  T* allocate(size_t const n) {
+    if (use_huge_pages(huge_pages_, n * sizeof(T))) {
+      void* ptr = allocate_huge_pages(huge_pages_, n * sizeof(T));
+#ifdef LCE_NUMA
+      if (numa_num_nodes() > 1) {
+        size_t const size = huge_page_mapping_size(huge_pages_, n * sizeof(T));
+        if (node_ >= 0) {
+          numa_tonode_memory(ptr, size, node_);
+        } else if (node_ == numa_interleaved) {
+          numa_interleave_memory(ptr, size, numa_all_nodes_ptr);
+        }
+      }
+#endif
+      return static_cast<T*>(ptr);
+    }
+#ifdef LCE_NUMA
+    if (uses_libnuma()) {
+      void* ptr = (node_ == numa_interleaved)
+                      ? numa_alloc_interleaved(n * sizeof(T))
+                      : numa_alloc_onnode(n * sizeof(T), node_);
+      if (ptr == nullptr) {
+        throw std::bad_alloc();
+      }
+      return static_cast<T*>(ptr);
+    }
+#endif
+    return static_cast<T*>(::operator new(n * sizeof(T)));
+  }
+
+  void deallocate(T* const ptr, [[maybe_unused]] size_t const n) {
+    if (use_huge_pages(huge_pages_, n * sizeof(T))) {
+      free_huge_pages(huge_pages_, ptr, n * sizeof(T));
+      return;
+    }
+#ifdef LCE_NUMA
+    if (uses_libnuma()) {
+      numa_free(ptr, n * sizeof(T));
+      return;
+    }
+#endif
+    ::operator delete(ptr);
+  }
+
+  /* Default initialization, i.e., no zeroing of trivial types. */
+  template <typename U>
+  void construct(U* const ptr)
+      noexcept(std::is_nothrow_default_constructible_v<U>) {
+    ::new (static_cast<void*>(ptr)) U;
+  }
+
+  template <typename U, typename... Args>
+  void construct(U* const ptr, Args&&... args) {
+    ::new (static_cast<void*>(ptr)) U(std::forward<Args>(args)...);
+  }
+
+  int node() const {
+    return node_;
+  }
+
+  huge_page_mode huge_pages() const {
+    return huge_pages_;
+  }
+
+  friend bool operator==(numa_allocator const& lhs, numa_allocator const& rhs) {
+    return lhs.node_ == rhs.node_ && lhs.huge_pages_ == rhs.huge_pages_;
+  }
+
+private:
+  bool uses_libnuma() const {
+    return node_ != -1 && numa_num_nodes() > 1;
+  }
+
+  int node_ = -1;  // -1: first touch
+  huge_page_mode huge_pages_ = global_huge_page_mode();
+};
+
+template <typename T>
+using numa_vector = std::vector<T, numa_allocator<T>>;
+
+/* Resizes an empty vector to n (uninitialized) elements and places its pages.
+ * With libnuma, the pages are interleaved over all nodes by the allocator.
+ * Otherwise, they are first touched by all OpenMP threads using a static
+ * schedule, such that each thread's part of the array resides on its node (as
+ * long as the threads are pinned, e.g., using OMP_PROC_BIND=spread). Parallel
+ * loops over the array should use schedule(static) as well. */
+template <typename T>
+void numa_resize(numa_vector<T>& v, size_t const n) {
+#ifdef LCE_NUMA
+  if (numa_num_nodes() > 1) {
+    v = numa_vector<T>(numa_allocator<T>(numa_interleaved, v.get_allocator().huge_pages()));
+  }
+#endif
+  v.resize(n);
+  if (n == 0) {
+    return;
+  }
+  // Touch one element per page
+  size_t const step = std::max<size_t>(1, 4096 / sizeof(T));
+  T* const data = v.data();
+#pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < n; i += step) {
+    data[i] = T{};
+  }
+}
+
+/* Copy of a vector whose memory is bound to the given node. */
+template <typename vector_type>
+numa_vector<typename vector_type::value_type> numa_copy(vector_type const& v,
+                                                        int const node) {
+  using value_type = typename vector_type::value_type;
+  numa_vector<value_type> copy(numa_allocator<value_type>{node});
+  copy.resize(v.size());
+  value_type const* const src = v.data();
+  value_type* const dst = copy.data();
+#pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < v.size(); ++i) {
+    dst[i] = src[i];
+  }
+  return copy;
+}
+
+} // namespace lce_test
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <time.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <malloc_count.h>
+
+namespace lce_test {
+
+/* Measurements of one construction phase. Times are given in milliseconds,
+ * memory in bytes. */
+struct phase_info {
+  std::string name;
+  uint64_t wall_time = 0;
+  uint64_t cpu_time = 0;         // CPU time of all threads of the process
+  uint64_t thread_cpu_time = 0;  // CPU time of the thread running the phase
+  int64_t mem_delta = 0;         // Memory still allocated after the phase
+  uint64_t mem_peak = 0;         // Additional memory peak during the phase
+};
+
+/* Collects wall time, CPU time and malloc_count deltas of consecutive
+ * construction phases. Starting a phase stops the currently running one.
+ * Without DETAILED_TIME, the global malloc_count peak is never reset, so the
+ * peak of a phase is only exact if it exceeds all previous peaks (otherwise
+ * it is a lower bound). With DETAILED_TIME, the peak is reset at the start of
+ * each phase, which gives exact phase peaks but invalidates all surrounding
+ * memory measurements. Parallel builds link a malloc_count stub that always
+ * returns 0 (malloc_count is not thread-safe), so there the memory of the
+ * phases is neither measured nor reported. */
+class phase_profiler {
+public:
+#ifdef ALLOW_PARALLEL
+  static constexpr bool kMeasuresMemory = false;
+#else
+  static constexpr bool kMeasuresMemory = true;
+#endif
+
+  void start(std::string name) {
+    stop();
+    running_ = true;
+    current_.name = std::move(name);
+    if constexpr (kMeasuresMemory) {
+#ifdef DETAILED_TIME
+      malloc_count_reset_peak();
+#endif
+      mem_before_ = static_cast<int64_t>(malloc_count_current());
+      peak_before_ = static_cast<int64_t>(malloc_count_peak());
+    }
+    wall_begin_ = std::chrono::steady_clock::now();
+    cpu_begin_ = cpu_now(CLOCK_PROCESS_CPUTIME_ID);
+    thread_cpu_begin_ = cpu_now(CLOCK_THREAD_CPUTIME_ID);
+  }
+
+  void stop() {
+    if (!running_) {
+      return;
+    }
+    auto const wall_end = std::chrono::steady_clock::now();
+    uint64_t const cpu_end = cpu_now(CLOCK_PROCESS_CPUTIME_ID);
+    uint64_t const thread_cpu_end = cpu_now(CLOCK_THREAD_CPUTIME_ID);
+
+    current_.wall_time = std::chrono::duration_cast<std::chrono::milliseconds>(
+        wall_end - wall_begin_).count();
+    current_.cpu_time = (cpu_end - cpu_begin_) / 1000000;
+    current_.thread_cpu_time = (thread_cpu_end - thread_cpu_begin_) / 1000000;
+    if constexpr (kMeasuresMemory) {
+      int64_t const mem_after = static_cast<int64_t>(malloc_count_current());
+      int64_t const peak_after = static_cast<int64_t>(malloc_count_peak());
+      current_.mem_delta = mem_after - mem_before_;
+      current_.mem_peak = static_cast<uint64_t>(std::max<int64_t>(
+          (peak_after > peak_before_) ? peak_after - mem_before_ : 0,
+          current_.mem_delta));
+    }
+    phases_.push_back(std::move(current_));
+    current_ = phase_info{};
+    running_ = false;
+  }
+
+  /* Stores an additional value (e.g. the size of a component), which is
+   * reported together with the phases. */
+  void set(std::string name, uint64_t const value) {
+    for (auto& counter : counters_) {
+      if (counter.first == name) {
+        counter.second = value;
+        return;
+      }
+    }
+    counters_.emplace_back(std::move(name), value);
+  }
+
+  std::vector<phase_info> const& phases() const {
+    return phases_;
+  }
+
+  std::vector<std::pair<std::string, uint64_t>> const& counters() const {
+    return counters_;
+  }
+
+  /* Returns the phase with the given name or nullptr if it does not exist. */
+  phase_info const* find(std::string_view const name) const {
+    for (auto const& phase : phases_) {
+      if (phase.name == name) {
+        return &phase;
+      }
+    }
+    return nullptr;
+  }
+
+  uint64_t total_wall_time() const {
+    uint64_t total = 0;
+    for (auto const& phase : phases_) {
+      total += phase.wall_time;
+    }
+    return total;
+  }
+
+  void clear() {
+    running_ = false;
+    phases_.clear();
+    counters_.clear();
+  }
+
+  /* Prints all phases in the RESULT format of our benchmarks, i.e.,
+   * "<phase>_time=... <phase>_cpu_time=... <phase>_mem=... " (the memory
+   * only if it is measured) */
+  friend std::ostream& operator<<(std::ostream& os, phase_profiler const& p) {
+    for (auto const& phase : p.phases_) {
+      os << phase.name << "_time=" << phase.wall_time << " "
+         << phase.name << "_cpu_time=" << phase.cpu_time << " "
+         << phase.name << "_thread_cpu_time=" << phase.thread_cpu_time << " ";
+      if constexpr (kMeasuresMemory) {
+        os << phase.name << "_mem=" << phase.mem_peak << " "
+           << phase.name << "_mem_delta=" << phase.mem_delta << " ";
+      }
+    }
+    for (auto const& counter : p.counters_) {
+      os << counter.first << "=" << counter.second << " ";
+    }
+    return os;
+  }
+
+private:
+  static uint64_t cpu_now(clockid_t const clock) {
+    timespec ts;
+    clock_gettime(clock, &ts);
+    return uint64_t(ts.tv_sec) * 1000000000ULL + uint64_t(ts.tv_nsec);
+  }
+
+  bool running_ = false;
+  phase_info current_;
+  int64_t mem_before_ = 0;
+  int64_t peak_before_ = 0;
+  std::chrono::steady_clock::time_point wall_begin_;
+  uint64_t cpu_begin_ = 0;
+  uint64_t thread_cpu_begin_ = 0;
+
+  std::vector<phase_info> phases_;
+  std::vector<std::pair<std::string, uint64_t>> counters_;
+}; // class phase_profiler
+
+} // namespace lce_test
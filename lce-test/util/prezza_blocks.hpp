@@ -0,0 +1,140 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+namespace lce_test {
+
+/* Building blocks of Prezza's in-place fingerprints, which are shared by
+ * LcePrezza and LcePrezzaDynamic. The text is read as big-endian blocks of 8
+ * characters, and each block is overwritten with a prefix fingerprint modulo a
+ * prime in (2^63, 2^64) (see fingerprint_policy.hpp). Bit 63 holds the helping
+ * bit, which tells whether the block is at least the prime, so a block is
+ * restored from its fingerprint, the previous fingerprint and the helping
+ * bit. */
+
+/* powers[k] = 256^(2^k), i.e., the factor that shifts a fingerprint by 2^k
+   characters */
+template <typename t_fingerprint>
+constexpr std::array<uint64_t, 70> prezza_powers(t_fingerprint const& fingerprint) {
+  __extension__ typedef unsigned __int128 uint128_t;
+  std::array<uint64_t, 70> powers;
+  uint128_t x = 256;
+  powers[0] = static_cast<uint64_t>(x);
+  for (size_t i = 1; i < powers.size(); ++i) {
+    x = fingerprint.reduce(x * x);
+    powers[i] = static_cast<uint64_t>(x);
+  }
+  return powers;
+}
+
+/* The block numbers whose fingerprint is at least 2^63 (in ascending order).
+   Their highest bit cannot be stored in place, as it holds the helping bit.
+   This only happens for fingerprints in [2^63, prime), i.e., rarely if the
+   prime is close to 2^63, so the list is usually empty and only searched
+   otherwise. */
+class prezza_high_fingerprints {
+public:
+  static constexpr uint64_t kHelpingBit = 0x8000000000000000ULL;
+
+  /* Returns the fingerprint of block i, which is stored in word */
+  uint64_t fingerprint(uint64_t const word, uint64_t const i) const {
+    uint64_t fingerprint = word & ~kHelpingBit;
+    if (!blocks_.empty()) [[unlikely]] {
+      if (std::binary_search(blocks_.begin(), blocks_.end(), i)) {
+        fingerprint |= kHelpingBit;
+      }
+    }
+    return fingerprint;
+  }
+
+  /* Returns the word that stores the fingerprint of block i and the helping
+     bit of block (i.e., whether block >= prime). Blocks can be encoded in any
+     order, but in ascending order the list is only appended to. */
+  uint64_t encode(uint64_t fingerprint, uint64_t const block,
+                  uint64_t const prime, uint64_t const i) {
+    if (fingerprint & kHelpingBit) [[unlikely]] {
+      fingerprint &= ~kHelpingBit;
+      if (blocks_.empty() || blocks_.back() < i) {
+        blocks_.push_back(i);
+      } else {
+        auto const it = std::lower_bound(blocks_.begin(), blocks_.end(), i);
+        if (*it != i) {
+          blocks_.insert(it, i);
+        }
+      }
+    } else if (!blocks_.empty()) [[unlikely]] {
+      auto const it = std::lower_bound(blocks_.begin(), blocks_.end(), i);
+      if (it != blocks_.end() && *it == i) {
+        blocks_.erase(it);
+      }
+    }
+    return (block >= prime) ? fingerprint | kHelpingBit : fingerprint;
+  }
+
+  static uint64_t helping_bit(uint64_t const word) {
+    return word >> 63;
+  }
+
+  void clear() {
+    blocks_.clear();
+  }
+
+  std::vector<uint64_t> const& blocks() const {
+    return blocks_;
+  }
+
+private:
+  std::vector<uint64_t> blocks_;
+};
+
+/* Compares up to t_naive_scan characters of the suffixes i and j blockwise and
+   returns min(lce, max_lce) if it is less than t_naive_scan (t_naive_scan
+   otherwise). first_block(b) returns any block, next_block(b) a block b >= 1
+   (which may skip the check for b = 0). */
+template <uint64_t t_naive_scan, typename first_block_type, typename next_block_type>
+uint64_t prezza_lce_scan(first_block_type const& first_block,
+                         next_block_type const& next_block,
+                         uint64_t const i, uint64_t const j, uint64_t const max_lce) {
+  uint64_t lce = 0;
+  /* compare blockwise */
+  const int offset_lce1 = (i % 8) * 8;
+  const int offset_lce2 = (j % 8) * 8;
+  uint64_t block_i = first_block(i/8);
+  uint64_t block_i2 = next_block(i/8 + 1);
+  uint64_t block_j = first_block(j/8);
+  uint64_t block_j2 = next_block(j/8 + 1);
+  uint64_t comp_block_i = (block_i << offset_lce1) +
+    ((block_i2 >> 1) >> (63-offset_lce1));
+  uint64_t comp_block_j = (block_j << offset_lce2) +
+    ((block_j2 >> 1) >> (63-offset_lce2));
+
+  const uint64_t max_block_naive = max_lce < t_naive_scan ? max_lce/8 : t_naive_scan/8;
+  while(lce < max_block_naive) {
+    if(comp_block_i != comp_block_j) {
+      break;
+    }
+    ++lce;
+    block_i = block_i2;
+    block_i2 = next_block((i/8)+lce+1);
+    block_j = block_j2;
+    block_j2 = next_block((j/8)+lce+1);
+    comp_block_i = (block_i << offset_lce1) +
+      ((block_i2 >> 1) >> (63-offset_lce1));
+    comp_block_j = (block_j << offset_lce2) +
+      ((block_j2 >> 1) >> (63-offset_lce2));
+  }
+  lce *= 8;
+  /* If everything except the stub matches, we compare the stub character-wise
+     and return the result */
+  if(lce != t_naive_scan) {
+    uint64_t max_stub = std::min((max_lce - lce), uint64_t{8});
+    return lce + std::min<uint64_t>(((std::countl_zero(comp_block_i ^ comp_block_j)) / 8), max_stub);
+  }
+  return t_naive_scan;
+}
+
+} // namespace lce_test
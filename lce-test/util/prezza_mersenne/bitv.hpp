@@ -62,14 +62,14 @@ public:
 
 	}
 
-	uint64_t size(){return n;}
+	uint64_t size() const {return n;}
 
 	/*
 	 * argument: position i in the bitvector
 	 * returns: bit in position i
 	 * only access! the bitvector is static.
 	 */
-	bool operator[](uint64_t i){
+	bool operator[](uint64_t i) const {
 
 		//assert(i<n);
 		return std::binary_search(ones.begin(),ones.end(),i);
@@ -80,7 +80,7 @@ public:
 	 * argument: position i in the bitvector, boolean b
 	 * returns: number of bits equal to b before position i excluded
 	 */
-	uint64_t rank(uint64_t i, bool b=true){
+	uint64_t rank(uint64_t i, bool b=true) const {
 
 		//assert(i<=n);
 
@@ -97,7 +97,7 @@ public:
 	 * WARNING: we require that the first bit in the bitvector is a 0
 	 *
 	 */
-	uint64_t predecessor_0(uint64_t i){
+	uint64_t predecessor_0(uint64_t i) const {
 
 		//assert(i<n);
 
@@ -130,6 +130,12 @@ public:
 
 	}
 
+	uint64_t size_in_bytes() const {
+
+		return ones.capacity()*sizeof(uint64_t);
+
+	}
+
 private:
 
 	vector<uint64_t> ones;//positions of 1's
@@ -256,7 +262,7 @@ private:
 
 		public:
 
-			pred_search(vector<uint64_t> * ones, uint64_t i){
+			pred_search(vector<uint64_t> const * ones, uint64_t i){
 
 				//assert(i<ones->size());
 
@@ -266,7 +272,7 @@ private:
 
 			}
 
-			uint64_t size(){return n;}
+			uint64_t size() const {return n;}
 
 			bool operator[](uint64_t j){
 
@@ -289,7 +295,7 @@ private:
 
 		private:
 
-			vector<uint64_t> * ones;
+			vector<uint64_t> const * ones;
 
 			//size: from the beginning of bv to i
 			uint64_t n;
@@ -133,6 +133,31 @@ inline int clz_u128 (uint128 u) {
   return retval[idx];
 }
 
+/*
+ * writes the value_bits low bits of value into a left-aligned word of
+ * word_bits bits, starting offset bits from the left. The bits before the
+ * word (offset < 0) and after it are dropped.
+ *
+ * complexity: O(1)
+ *
+ */
+inline void or_bits(uint128 & word, uint64_t word_bits, uint128 value,
+                    uint64_t value_bits, int64_t offset){
+
+	if(offset < 0){
+
+		value_bits += offset;
+		value &= (uint128(1) << value_bits) - 1;
+		offset = 0;
+
+	}
+
+	int64_t shift = int64_t(word_bits) - offset - int64_t(value_bits);
+
+	word |= shift >= 0 ? value << shift : value >> (-shift);
+
+}
+
 
 /*
  * simulates a vector of 127-bits integers
@@ -163,26 +188,28 @@ public:
 		//blocks are left-aligned
 		blocks = vector<uint128>(n_bl,0);
 
-		uint64_t i = 0;
-		for(auto block:B){
+		//each word is assembled from the (at most two) values overlapping it
+		#pragma omp parallel for schedule(static)
+		for(uint64_t j = 0; j < n_bl; ++j){
 
-			//the vector must contain 127-bits integers
-			assert( block < uint128(1)<<BL );
+			uint128 word = 0;
 
-			for(uint64_t j = 0; j < BL; ++j){
+			for(uint64_t i = (j*W) / BL; i < n && i*BL < (j+1)*W; ++i){
 
-				uint128 b = (block >> (BL - (j+1))) & uint128(1);
+				//the vector must contain 127-bits integers
+				assert( B[i] < uint128(1)<<BL );
 
-				blocks[i/W] |= (b << (W-(i%W+1)) );
-				i++;
+				or_bits(word, W, B[i], BL, int64_t(i*BL) - int64_t(j*W));
 
 			}
 
+			blocks[j] = word;
+
 		}
 
 	}
 
-	uint128 operator[](uint64_t i){
+	uint128 operator[](uint64_t i) const {
 
 		assert(i<n);
 
@@ -206,10 +233,10 @@ public:
 
 	}
 
-	uint64_t size(){
+	uint64_t size() const {
 		return n;
 	}
-	uint64_t length(){
+	uint64_t length() const {
 		return n;
 	}
 
@@ -219,6 +246,12 @@ public:
 
 	}
 
+	uint64_t size_in_bytes() const {
+
+		return blocks.capacity()*sizeof(uint128);
+
+	}
+
 private:
 
 	//word size: we use 128-bits integers
@@ -69,78 +69,64 @@ public:
 
     assert(n % w == 0);
 
-    // number of 127-bits blocks
-    auto n_bl = n / w;
-
-    assert(n_bl > 0);
-
-    // array P_vec: prefix sums of blocks different than q
-    vector<uint128> P_vec;
-
-    {
-
-      // pack bits in blocks of w bits: array B
-
-      auto B_vec = vector<uint128>(n_bl, 0);
-
-      uint64_t i = 0;
-      for (auto b : input_bitvector) {
-
-        B_vec[i / w] |= (uint128(b) << (w - (i % w + 1)));
-        i++;
-      }
+    // pack bits in blocks of w bits: array B
 
-      // first block must be different than q
-      assert(B_vec[0] != q);
+    auto B_vec = vector<uint128>(n / w, 0);
 
-      // detect full blocks
+    uint64_t i = 0;
+    for (auto b : input_bitvector) {
 
-      uint64_t number_full_blocks = 0;
-      for (auto bl : B_vec)
-        number_full_blocks += bl == q;
-
-      // Build bitvector Q1
-
-      {
+      B_vec[i / w] |= (uint128(b) << (w - (i % w + 1)));
+      i++;
+    }
 
-        vector<bool> Q_vec;
+    build(B_vec);
+  }
 
-        i = 0;
-        for (auto bl : B_vec)
-          Q_vec.push_back(bl == q);
+  /*
+   * Build RK-LCE structure over the binary encoding of text[0, text_size),
+   * preceded by pad 0's, without materializing the bitvector: each character
+   * is encoded with char_to_uint using bits_per_char bits. The size of the
+   * encoding must be a multiple of w.
+   *
+   * The blocks are packed with one shift per character, in parallel.
+   */
+  rk_lce_bin(uint8_t const* text, uint64_t text_size,
+             vector<uint8_t> const& char_to_uint, uint64_t bits_per_char,
+             uint64_t pad) {
 
-        Q1 = bitv(Q_vec);
+    n = pad + text_size * bits_per_char;
 
-        assert(Q1.rank(Q1.size()) == number_full_blocks);
-      }
+    assert(n % w == 0);
 
-      // cout << Q1.rank(Q1.size()) << " full blocks"<<endl;
-      // cout << Q1.rank(Q1.size(),0) << " non-full blocks"<<endl;
+    auto B_vec = vector<uint128>(n / w, 0);
 
-      // NOW COMPUTE PREFIX SUMS (array P' in the paper. here we overwrite B_vec
-      // with P')
+    #pragma omp parallel for schedule(static)
+    for (uint64_t j = 0; j < B_vec.size(); ++j) {
 
-      for (uint64_t i = 1; i < B_vec.size(); ++i) {
+      // characters overlapping bits [j * w, (j + 1) * w)
+      uint64_t const first_bit = j * w;
+      uint64_t const last_bit = first_bit + w - 1;
 
-        B_vec[i] = (B_vec[i] + mul_pow2<w>(B_vec[i - 1], w)) % q;
-      }
+      if (last_bit < pad)
+        continue;
 
-      // P_vec is never empty because we require B[0] != q
-      P_vec = vector<uint128>(Q1.rank(Q1.size(), 0));
+      uint64_t const first_char =
+          first_bit < pad ? 0 : (first_bit - pad) / bits_per_char;
+      uint64_t const last_char = (last_bit - pad) / bits_per_char;
 
-      uint64_t i_P_vec = 0;
-      for (uint64_t j = 0; j < Q1.size(); ++j) {
+      uint128 block = 0;
 
-        if (not Q1[j]) {
+      for (uint64_t c = first_char; c <= last_char; ++c) {
 
-          assert(i_P_vec < P_vec.size());
-          P_vec[i_P_vec++] = B_vec[j];
-        }
+        or_bits(block, w, char_to_uint[text[c]], bits_per_char,
+                int64_t(pad + c * bits_per_char) - int64_t(first_bit));
       }
 
-    } // destroy B_vec
+      B_vec[j] = block;
+    }
 
-    P = packed_vector_127(P_vec);
+    build(B_vec);
   }
 
   inline uint64_t bit_size() {
@@ -148,13 +134,24 @@ public:
     return P.bit_size() + Q1.bit_size() + sizeof(this) * 8;
   }
 
+  /*
+   * space of the packed prefix fingerprints P and the sparse bitvector Q'
+   */
+  inline uint64_t size_in_bytes_P() const {
+    return P.size_in_bytes();
+  }
+
+  inline uint64_t size_in_bytes_Q() const {
+    return Q1.size_in_bytes();
+  }
+
   /*
    * access i-th bit
    *
    * complexity: O(1)
    *
    */
-  inline bool operator[](uint64_t i) {
+  inline bool operator[](uint64_t i) const {
 
     assert(i < n);
 
@@ -170,7 +167,7 @@ public:
    * block must fit in a memory word: len <= 128
    *
    */
-  inline uint128 operator()(uint64_t i, uint64_t len = 128) {
+  inline uint128 operator()(uint64_t i, uint64_t len = 128) const {
 
     assert(len <= 128);
 
@@ -196,14 +193,29 @@ public:
    * - O(log n) otherwise
    *
    */
-  inline uint64_t LCE(uint64_t i, uint64_t j) {
+  inline uint64_t LCE(uint64_t i, uint64_t j) const {
+    return LCE(i, j, n);
+  }
+
+  /*
+   * min(LCE, cap) between i-th and j-th suffixes. The exponential search
+   * stops at cap.
+   *
+   * complexity:
+   *
+   * - O(1) if the LCE or cap is shorter than memory word (128 bits)
+   *
+   * - O(log cap) otherwise
+   *
+   */
+  inline uint64_t LCE(uint64_t i, uint64_t j, uint64_t cap) const {
 
     assert(i < n);
     assert(j < n);
 
     // same suffix
     if (i == j)
-      return n - i;
+      return std::min(n - i, cap);
 
     // one of the two suffixes are empty
     if (i == n or j == n)
@@ -216,11 +228,11 @@ public:
     auto i_block = operator()(i);
     auto j_block = operator()(j);
 
-    if (i_block != j_block or i_len <= 128 or j_len <= 128) {
+    if (i_block != j_block or i_len <= 128 or j_len <= 128 or cap <= 128) {
 
       uint64_t lce = clz_u128(i_block ^ j_block);
 
-      uint64_t min = std::min(i_len, j_len);
+      uint64_t min = std::min(std::min(i_len, j_len), cap);
 
       lce = lce > min ? min : lce;
 
@@ -229,8 +241,8 @@ public:
       return lce;
     }
 
-    auto lce = LCE_binary(i, j);
-    assert(lce == LCE_naive(i, j));
+    auto lce = LCE_binary(i, j, cap);
+    assert(cap < n or lce == LCE_naive(i, j));
 
     return lce;
   }
@@ -246,7 +258,7 @@ public:
    *
    */
   inline bool equals(
-      uint64_t i, uint64_t j, uint64_t l, uint128 i_fp = q, uint128 j_fp = q) {
+      uint64_t i, uint64_t j, uint64_t l, uint128 i_fp = q, uint128 j_fp = q) const {
 
     assert(i + l - 1 < n);
     assert(j + l - 1 < n);
@@ -260,7 +272,7 @@ public:
   /*
    * O(n)-time implementation of LCE
    */
-  inline uint64_t LCE_naive(uint64_t i, uint64_t j) {
+  inline uint64_t LCE_naive(uint64_t i, uint64_t j) const {
 
     if (i == j)
       return n - i;
@@ -274,28 +286,117 @@ public:
     return lce;
   }
 
-  inline uint64_t number_of_blocks() {
+  inline uint64_t number_of_blocks() const {
     return Q1.size();
   }
 
-  inline uint64_t block_size() {
+  inline uint64_t block_size() const {
     return w;
   }
 
-  inline uint64_t length() {
+  inline uint64_t length() const {
     return n;
   }
 
-  inline uint64_t size() {
+  inline uint64_t size() const {
     return n;
   }
 
 private:
+  // blocks per chunk of the parallel prefix sums
+  static constexpr uint64_t kChunkSize = uint64_t(1) << 16;
+
+  /*
+   * Builds Q' and P from the blocks B (which are overwritten).
+   *
+   * Since 2^w = 1 mod q, the prefix fingerprints P'[i] = P'[i-1] * 2^w + B[i]
+   * are prefix sums mod q. They are computed in parallel chunks: first the
+   * sum of each chunk, then the prefix sums inside each chunk starting at the
+   * sum of all previous chunks.
+   */
+  void build(vector<uint128>& B_vec) {
+
+    // number of 127-bits blocks
+    auto n_bl = B_vec.size();
+
+    assert(n_bl > 0);
+
+    // first block must be different than q
+    assert(B_vec[0] != q);
+
+    // Build bitvector Q1
+    {
+
+      vector<bool> Q_vec(n_bl);
+
+      for (uint64_t i = 0; i < n_bl; ++i)
+        Q_vec[i] = B_vec[i] == q;
+
+      Q1 = bitv(Q_vec);
+    }
+
+    uint64_t const n_chunks = (n_bl + kChunkSize - 1) / kChunkSize;
+
+    // sum and number of non-full blocks of each chunk, then of all previous
+    // chunks
+    vector<uint128> chunk_sum(n_chunks + 1, 0);
+    vector<uint64_t> chunk_non_full(n_chunks + 1, 0);
+
+    #pragma omp parallel for schedule(static)
+    for (uint64_t c = 0; c < n_chunks; ++c) {
+
+      uint128 sum = 0;
+      uint64_t non_full = 0;
+
+      for (uint64_t i = c * kChunkSize; i < std::min(n_bl, (c + 1) * kChunkSize); ++i) {
+
+        sum = (sum + B_vec[i]) % q;
+        non_full += B_vec[i] != q;
+      }
+
+      chunk_sum[c + 1] = sum;
+      chunk_non_full[c + 1] = non_full;
+    }
+
+    for (uint64_t c = 0; c < n_chunks; ++c) {
+
+      chunk_sum[c + 1] = (chunk_sum[c + 1] + chunk_sum[c]) % q;
+      chunk_non_full[c + 1] += chunk_non_full[c];
+    }
+
+    assert(Q1.rank(Q1.size(), 0) == chunk_non_full[n_chunks]);
+
+    // NOW COMPUTE PREFIX SUMS (array P' in the paper) and keep those of the
+    // blocks different than q
+
+    // P_vec is never empty because we require B[0] != q
+    vector<uint128> P_vec(chunk_non_full[n_chunks]);
+
+    #pragma omp parallel for schedule(static)
+    for (uint64_t c = 0; c < n_chunks; ++c) {
+
+      uint128 prefix = chunk_sum[c];
+      uint64_t i_P_vec = chunk_non_full[c];
+
+      for (uint64_t i = c * kChunkSize; i < std::min(n_bl, (c + 1) * kChunkSize); ++i) {
+
+        prefix = (prefix + B_vec[i]) % q;
+
+        if (B_vec[i] != q)
+          P_vec[i_P_vec++] = prefix;
+      }
+    }
+
+    B_vec = vector<uint128>();
+
+    P = packed_vector_127(P_vec);
+  }
+
   /*
    * rabin-karp fingerprint of T[0,...,i]
    *
    */
-  inline uint128 RK(uint64_t i) {
+  inline uint128 RK(uint64_t i) const {
 
     auto j = i / w;
 
@@ -311,7 +412,7 @@ private:
    * for efficiency, rki=RK(i-1) can be specified as input
    *
    */
-  inline uint128 RK(uint64_t i, uint64_t j, uint128 rki = q) {
+  inline uint128 RK(uint64_t i, uint64_t j, uint128 rki = q) const {
 
     assert(j >= i);
 
@@ -331,7 +432,7 @@ private:
    * complexity: O(log m)
    *
    */
-  inline uint128 P1(uint64_t i) {
+  inline uint128 P1(uint64_t i) const {
 
     // if there are no full blocks, speed up computation of P'[i]
 
@@ -353,7 +454,7 @@ private:
    * complexity: O(log m)
    *
    */
-  inline uint128 B(uint64_t i) {
+  inline uint128 B(uint64_t i) const {
 
     assert(i < Q1.size());
 
@@ -379,7 +480,7 @@ private:
    * complexity: O(log n) (a binary search)
    *
    */
-  inline uint64_t LCE_binary(uint64_t i, uint64_t j) {
+  inline uint64_t LCE_binary(uint64_t i, uint64_t j, uint64_t cap) const {
 
     assert(i != j);
 
@@ -389,14 +490,17 @@ private:
 
     auto sc = suffix_comparator(this, i, j);
 
+    // sc[cap + 1] is not needed: if sc[0, cap] contains no 1, the result is cap
+    uint64_t const limit = std::min<uint64_t>(sc.size(), cap + 1);
+
     uint64_t k = 1;
 
     // exponential search
 
-    while (k < sc.size() && not sc[k])
+    while (k < limit && not sc[k])
       k *= 2;
-    if (k >= sc.size())
-      k = sc.size();
+    if (k >= limit)
+      k = limit;
 
     // cout << endl;
     // for(int i=0;i< 100;++i) cout << sc[i];cout << endl;
@@ -542,7 +646,7 @@ private:
     };
 
   public:
-    suffix_comparator(rk_lce_bin* T, uint64_t i, uint64_t j) {
+    suffix_comparator(rk_lce_bin const* T, uint64_t i, uint64_t j) {
 
       // check these conditions outside this class
       assert(i != j);
@@ -602,7 +706,7 @@ private:
     }
 
   private:
-    rk_lce_bin* T;
+    rk_lce_bin const* T;
 
     uint64_t n;
 
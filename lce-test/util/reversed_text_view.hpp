@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+namespace lce_test {
+
+/* Read-only view of a text in reverse order, i.e., view[i] = text[n - 1 - i].
+ * Forward LCE queries on the view are backward LCE queries (longest common
+ * suffixes) on the text, without a reversed copy of the text. */
+class reversed_text_view {
+public:
+  using value_type = uint8_t;
+  using const_iterator = std::reverse_iterator<uint8_t const*>;
+
+  reversed_text_view(uint8_t const* const text, size_t const size)
+      : text_(text), size_(size) {}
+
+  inline uint8_t operator[](size_t const i) const {
+    return text_[size_ - 1 - i];
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+  const_iterator cbegin() const {
+    return const_iterator(text_ + size_);
+  }
+
+  const_iterator cend() const {
+    return const_iterator(text_);
+  }
+
+  /* Position in the text of the i-th character of the view (and vice
+     versa). */
+  inline size_t mirror(size_t const i) const {
+    return size_ - 1 - i;
+  }
+
+private:
+  uint8_t const* text_;
+  size_t size_;
+}; // class reversed_text_view
+
+} // namespace lce_test
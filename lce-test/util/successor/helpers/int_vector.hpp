@@ -1,5 +1,6 @@
 #pragma once
     
+#include <memory>
 #include <vector>
 #include <utility>
 
@@ -7,12 +8,13 @@
 
 namespace stash {
 
-class int_vector {
+template<typename allocator_t = std::allocator<uint64_t>>
+class basic_int_vector {
 private:
     size_t m_size;
     size_t m_width;
     size_t m_mask;
-    std::vector<uint64_t> m_data;
+    std::vector<uint64_t, allocator_t> m_data;
 
     inline void set(size_t i, uint64_t v) {
         v &= m_mask; // make sure it fits...
@@ -72,7 +74,7 @@ private:
 
 public:
     struct Ref {
-        int_vector* iv;
+        basic_int_vector* iv;
         size_t i;
 
         inline operator uint64_t() const {
@@ -84,22 +86,30 @@ public:
         }
     };
 
-    inline int_vector() : m_size(0), m_width(0), m_mask(0) {
+    inline basic_int_vector() : m_size(0), m_width(0), m_mask(0) {
     }
 
-    inline int_vector(const int_vector& other) {
+    inline basic_int_vector(const basic_int_vector& other) {
         *this = other;
     }
 
-    inline int_vector(int_vector&& other) {
+    // copy that uses the given allocator, e.g., to place it on another NUMA node
+    inline basic_int_vector(const basic_int_vector& other, const allocator_t& alloc)
+        : m_size(other.m_size),
+          m_width(other.m_width),
+          m_mask(other.m_mask),
+          m_data(other.m_data, alloc) {
+    }
+
+    inline basic_int_vector(basic_int_vector&& other) {
         *this = std::move(other);
     }
 
-    inline int_vector(size_t size, size_t width) {
+    inline basic_int_vector(size_t size, size_t width) {
         resize(size, width);
     }
 
-    inline int_vector& operator=(const int_vector& other) {
+    inline basic_int_vector& operator=(const basic_int_vector& other) {
         m_size = other.m_size;
         m_width = other.m_width;
         m_mask = other.m_mask;
@@ -107,7 +117,7 @@ public:
         return *this;
     }
 
-    inline int_vector& operator=(int_vector&& other) {
+    inline basic_int_vector& operator=(basic_int_vector&& other) {
         m_size = other.m_size;
         m_width = other.m_width;
         m_mask = other.m_mask;
@@ -127,7 +137,7 @@ public:
     }
 
     inline void rebuild(size_t size, size_t width) {
-        int_vector new_iv(size, width);
+        basic_int_vector new_iv(size, width);
         for(size_t i = 0; i < size; i++) {
             new_iv.set(i, get(i));
         }
@@ -153,6 +163,21 @@ public:
     inline size_t size() const {
         return m_size;
     }
+
+    inline size_t size_in_bytes() const {
+        return m_data.capacity() * sizeof(uint64_t);
+    }
+
+    // the underlying words, e.g., to initialize them in parallel
+    inline uint64_t* data() {
+        return m_data.data();
+    }
+
+    inline size_t num_words() const {
+        return m_data.size();
+    }
 };
 
+using int_vector = basic_int_vector<>;
+
 }
@@ -64,6 +64,11 @@ public:
         m_hi_idx[m_key_max - m_key_min + 1] = m_num;
     }
 
+    // space of the index (without the indexed array)
+    inline size_t size_in_bytes() const {
+        return m_hi_idx.size_in_bytes();
+    }
+
     // finds the greatest element less than OR equal to x
     inline result predecessor(const item_t x) const {
         if(unlikely(x < m_min))  return result { false, 0 };
@@ -5,6 +5,7 @@
 
 #include "helpers/util.hpp"
 #include "helpers/int_vector.hpp"
+#include "../numa.hpp"
 
 #include "result.hpp"
 
@@ -33,7 +34,7 @@ private:
     uint64_t m_key_min;
     uint64_t m_key_max;
 
-    int_vector m_hi_idx;
+    basic_int_vector<lce_test::numa_allocator<uint64_t>> m_hi_idx;
 
 public:
     inline index_par(const array_t& array)
@@ -47,7 +48,14 @@ public:
         // build an index for high bits
         m_key_min = uint64_t(m_min) >> m_lo_bits;
         m_key_max = uint64_t(m_max) >> m_lo_bits;
-        m_hi_idx = int_vector(m_key_max - m_key_min + 2, log2_ceil(m_num));
+        // the allocator does not initialize the words, so they are first
+        // touched (and placed) by the threads that fill them
+        m_hi_idx.resize(m_key_max - m_key_min + 2, log2_ceil(m_num));
+        uint64_t* const hi_idx_words = m_hi_idx.data();
+        #pragma omp parallel for schedule(static)
+        for(size_t w = 0; w < m_hi_idx.num_words(); ++w) {
+            hi_idx_words[w] = 0;
+        }
         #pragma omp parallel
         {
             const int t = omp_get_thread_num();
@@ -73,6 +81,23 @@ public:
         m_hi_idx[m_key_max - m_key_min + 1] = m_num;
     }
 
+    // copy of the index for a copy of the indexed array, with the index bound
+    // to the given NUMA node
+    inline index_par(const index_par& other, const array_t& array, const int node)
+        : m_array(&array),
+          m_num(other.m_num),
+          m_min(other.m_min),
+          m_max(other.m_max),
+          m_key_min(other.m_key_min),
+          m_key_max(other.m_key_max),
+          m_hi_idx(other.m_hi_idx, lce_test::numa_allocator<uint64_t>(node)) {
+    }
+
+    // space of the index (without the indexed array)
+    inline size_t size_in_bytes() const {
+        return m_hi_idx.size_in_bytes();
+    }
+
     // finds the greatest element less than OR equal to x
     inline result predecessor(const item_t x) const {
         if(unlikely(x < m_min))  return result { false, 0 };
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+
+#include "helpers/util.hpp"
+#include "helpers/int_vector.hpp"
+#include "../numa.hpp"
+
+#include "result.hpp"
+
+namespace stash {
+namespace pred {
+
+// successor queries on a string synchronizing set with parameter tau
+//
+// Outside of runs, each window of tau text positions contains a
+// synchronizing position, and there are at most about 6n/tau of them. Hence,
+// sampling the successor every m_step = tau / samples_per_tau positions leaves
+// only a few elements between two samples. A query is one load from the
+// sample table followed by a branch-free count over the next m_scan elements
+// of the array (which the caller reads anyway). Only buckets with more
+// elements fall back to a binary search. In contrast to index_par, the
+// sampling rate follows tau instead of a fixed number of low bits, so the
+// table is much smaller and more likely to be cached.
+template<
+    typename array_t,
+    typename item_t,
+    uint64_t tau,
+    uint64_t samples_per_tau = 1,
+    size_t m_scan = 8>
+class sss_index {
+private:
+    static constexpr uint64_t m_step = std::bit_floor(std::max<uint64_t>(1, tau / samples_per_tau));
+    static constexpr uint64_t m_lo_bits = std::countr_zero(m_step);
+
+    static constexpr uint64_t hi(uint64_t x) {
+        return x >> m_lo_bits;
+    }
+
+    const array_t* m_array;
+    size_t m_num;
+    item_t m_min;
+    item_t m_max;
+
+    // m_sample[k] is the position of the smallest element >= k * m_step
+    basic_int_vector<lce_test::numa_allocator<uint64_t>> m_sample;
+
+public:
+    inline sss_index(const array_t& array)
+        : m_array(&array),
+          m_num(array.size()),
+          m_min(array[0]),
+          m_max(array[m_num-1]) {
+
+        assert_sorted_ascending(array);
+
+        // groups of 64 samples fill whole words, so threads that write
+        // different groups never share a word; the allocator does not
+        // initialize the words, so each thread clears (and places) the
+        // words of its groups first
+        const size_t num_samples = hi(m_max) + 2;
+        const size_t width = log2_ceil(m_num);
+        m_sample.resize(num_samples, width);
+        uint64_t* const sample_words = m_sample.data();
+        const size_t num_groups = (num_samples + 63) / 64;
+        #pragma omp parallel for schedule(static)
+        for(size_t g = 0; g < num_groups; ++g) {
+            const size_t end_word = std::min(m_sample.num_words(), (g + 1) * width);
+            for(size_t w = g * width; w < end_word; ++w) {
+                sample_words[w] = 0;
+            }
+            const size_t first = g * 64;
+            const size_t last = std::min(num_samples, first + 64);
+            const item_t* const data = array.data();
+            size_t i = std::lower_bound(data, data + m_num, item_t(first << m_lo_bits)) - data;
+            for(size_t k = first; k < last; ++k) {
+                while(i < m_num && hi(data[i]) < k) ++i;
+                m_sample[k] = i;
+            }
+        }
+    }
+
+    // copy of the index for a copy of the indexed array, with the index bound
+    // to the given NUMA node
+    inline sss_index(const sss_index& other, const array_t& array, const int node)
+        : m_array(&array),
+          m_num(other.m_num),
+          m_min(other.m_min),
+          m_max(other.m_max),
+          m_sample(other.m_sample, lce_test::numa_allocator<uint64_t>(node)) {
+    }
+
+    // space of the index (without the indexed array)
+    inline size_t size_in_bytes() const {
+        return m_sample.size_in_bytes();
+    }
+
+    // finds the greatest element less than OR equal to x
+    inline result predecessor(const item_t x) const {
+        if(unlikely(x < m_min))  return result { false, 0 };
+        if(unlikely(x >= m_max)) return result { true, m_num-1 };
+
+        // the predecessor precedes the successor of x + 1
+        return {true, find(x + 1) - 1};
+    }
+
+    // finds the smallest element greater than OR equal to x
+    inline result successor(const item_t x) const {
+        if(unlikely(x <= m_min)) return result { true, 0 };
+        if(unlikely(x > m_max))  return result { false, 0 };
+
+        return {true, find(x)};
+    }
+
+private:
+    // position of the smallest element >= x for m_min < x <= m_max
+    inline size_t find(const item_t x) const {
+        const item_t* const data = m_array->data();
+        const uint64_t key = hi(x);
+        const size_t p = m_sample[key];
+        if(likely(p + m_scan <= m_num)) {
+            // all elements from p on are >= key * m_step, so the successor
+            // follows the elements that are smaller than x
+            size_t smaller = 0;
+            for(size_t k = 0; k < m_scan; ++k) {
+                smaller += (data[p + k] < x);
+            }
+            if(likely(smaller < m_scan)) {
+                return p + smaller;
+            }
+            return std::lower_bound(data + p + m_scan, data + m_sample[key + 1], x) - data;
+        }
+        return std::lower_bound(data + p, data + m_num, x) - data;
+    }
+};
+
+}}
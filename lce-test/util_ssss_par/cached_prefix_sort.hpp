@@ -0,0 +1,186 @@
+#pragma once
+
+#include <omp.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include <ips4o.hpp>
+
+#include "ssss_par.hpp"
+
+namespace lce_test::par {
+
+/* Sorts the strings T[s, s + 3 * t_tau) at the positions s of a string
+ * synchronizing set in the order used by Lce_rmq_par: lexicographically,
+ * where a string that is cut off by the end of the text is smaller than its
+ * extensions, and equal strings are ordered by run information and then by
+ * decreasing position. The strings are given by their indices in the set.
+ *
+ * The next 8 characters of each string are cached as an integer key next to
+ * its index, so each round sorts a contiguous array of integers and reads
+ * the text only once per string. Strings with equal keys form a group, which
+ * is refined in the next round with the following 8 characters. Large groups
+ * are sorted with all threads, small groups in parallel. The group boundaries
+ * also tell which adjacent strings are equal, so they can be ranked without
+ * comparing them again. */
+template <uint64_t t_tau, typename sss_type, typename text_iterator>
+class cached_prefix_sorter {
+  static constexpr uint64_t kKeyLength = sizeof(uint64_t);
+  static constexpr uint64_t kStringLength = 3 * t_tau;
+  static constexpr size_t kParallelGroupSize = size_t{1} << 16;
+
+  struct cached_string {
+    uint64_t key;
+    sss_type index;
+  };
+
+  struct group {
+    size_t begin;
+    size_t end;
+  };
+
+ public:
+  cached_prefix_sorter(text_iterator const text, uint64_t const text_size,
+                       string_synchronizing_set_par<t_tau, sss_type> const& sync_set)
+      : m_text(text), m_text_size(text_size), m_sync_set(sync_set) {}
+
+  /* Sorts the indices (of positions in the string synchronizing set) by
+     their strings */
+  void sort(std::vector<sss_type>& indices) const {
+    sort(indices, nullptr);
+  }
+
+  /* Sorts the indices like sort(indices) and sets differs[i] to whether the
+     i-th sorted string differs from its predecessor (differs[0] = 1). Equal
+     strings have equal lengths and run information. */
+  void sort(std::vector<sss_type>& indices, std::vector<uint8_t>& differs) const {
+    differs.assign(indices.size(), 1);
+    sort(indices, differs.data());
+  }
+
+ private:
+  /* differs (if not null) is initialized with ones. Each position within a
+     group is set when it is placed in its final order, i.e., when its string
+     ends within the current key; the first position of a group keeps the
+     value that was set for the enclosing group. */
+  void sort(std::vector<sss_type>& indices, uint8_t* const differs) const {
+    std::vector<cached_string> cache(indices.size());
+#pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < indices.size(); ++i) {
+      cache[i].index = indices[i];
+    }
+
+    std::vector<group> groups;
+    if (cache.size() > 1) {
+      groups.push_back({0, cache.size()});
+    }
+    for (uint64_t depth = 0; !groups.empty(); depth += kKeyLength) {
+      std::vector<group> next_groups;
+      for (auto const& g : groups) {
+        if (g.end - g.begin >= kParallelGroupSize) {
+#pragma omp parallel for schedule(static)
+          for (size_t i = g.begin; i < g.end; ++i) {
+            cache[i].key = key_at(cache[i].index, depth);
+          }
+          ips4o::parallel::sort(cache.begin() + g.begin, cache.begin() + g.end, by_key);
+          split(cache, g, depth, differs, next_groups);
+        }
+      }
+#pragma omp parallel
+      {
+        std::vector<group> local_groups;
+#pragma omp for schedule(dynamic, 64) nowait
+        for (size_t k = 0; k < groups.size(); ++k) {
+          group const g = groups[k];
+          if (g.end - g.begin < kParallelGroupSize) {
+            for (size_t i = g.begin; i < g.end; ++i) {
+              cache[i].key = key_at(cache[i].index, depth);
+            }
+            std::sort(cache.begin() + g.begin, cache.begin() + g.end, by_key);
+            split(cache, g, depth, differs, local_groups);
+          }
+        }
+#pragma omp critical(cached_prefix_sort_groups)
+        next_groups.insert(next_groups.end(), local_groups.begin(), local_groups.end());
+      }
+      groups = std::move(next_groups);
+    }
+
+#pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < indices.size(); ++i) {
+      indices[i] = cache[i].index;
+    }
+  }
+
+  static bool by_key(cached_string const& a, cached_string const& b) {
+    return a.key < b.key;
+  }
+
+  uint64_t length(sss_type const index) const {
+    return std::min<uint64_t>(kStringLength, m_text_size - m_sync_set[index]);
+  }
+
+  /* Characters [depth, depth + 8) of the string, big-endian and padded with
+     zeros after its end */
+  uint64_t key_at(sss_type const index, uint64_t const depth) const {
+    uint64_t const position = m_sync_set[index];
+    uint64_t const end = std::min<uint64_t>(kStringLength, m_text_size - position);
+    uint64_t key = 0;
+    for (uint64_t k = depth; k < depth + kKeyLength; ++k) {
+      key = (key << 8) | (k < end ? uint64_t{m_text[position + k]} : 0);
+    }
+    return key;
+  }
+
+  /* Splits the sorted group g into groups of equal keys. In each of them,
+     the strings that end within the key are equal to a prefix of the others
+     and are placed first, ordered by (length, run information, decreasing
+     position); the others form a new group for the next depth. Adjacent
+     strings that end within the key are equal iff they have the same length
+     and run information. */
+  void split(std::vector<cached_string>& cache, group const g, uint64_t const depth,
+             uint8_t* const differs, std::vector<group>& next_groups) const {
+    for (size_t begin = g.begin; begin < g.end;) {
+      size_t end = begin + 1;
+      while (end < g.end && cache[end].key == cache[begin].key) {
+        ++end;
+      }
+      if (end - begin > 1) {
+        auto const ends = [&](cached_string const& s) {
+          return length(s.index) <= depth + kKeyLength;
+        };
+        auto const unfinished = std::stable_partition(cache.begin() + begin, cache.begin() + end, ends);
+        std::sort(cache.begin() + begin, unfinished, [&](cached_string const& a, cached_string const& b) {
+          uint64_t const length_a = length(a.index);
+          uint64_t const length_b = length(b.index);
+          if (length_a != length_b) {
+            return length_a < length_b;
+          }
+          int64_t const run_info_a = m_sync_set.get_run_info(m_sync_set[a.index]);
+          int64_t const run_info_b = m_sync_set.get_run_info(m_sync_set[b.index]);
+          return run_info_a < run_info_b || (run_info_a == run_info_b && a.index > b.index);
+        });
+        size_t const next_begin = unfinished - cache.begin();
+        if (differs != nullptr) {
+          for (size_t i = begin + 1; i < next_begin; ++i) {
+            differs[i] = length(cache[i - 1].index) != length(cache[i].index) ||
+                         m_sync_set.get_run_info(m_sync_set[cache[i - 1].index]) !=
+                             m_sync_set.get_run_info(m_sync_set[cache[i].index]);
+          }
+        }
+        if (end - next_begin > 1) {
+          next_groups.push_back({next_begin, end});
+        }
+      }
+      begin = end;
+    }
+  }
+
+  text_iterator const m_text;
+  uint64_t const m_text_size;
+  string_synchronizing_set_par<t_tau, sss_type> const& m_sync_set;
+};
+
+}  // namespace lce_test::par
@@ -10,180 +10,156 @@
 #pragma once
 
 #include <algorithm>  //std::sort
+#include <limits>
 #include <chrono>
+#include <random>
+#include <stdexcept>
 #include <string>
 #include <vector>
 #include <src/libsais64.h>
 #include <src/libsais.h>
 
 #include <ips4o.hpp>
-#include <tlx/sort/strings/parallel_sample_sort.hpp>
 
+#include "cached_prefix_sort.hpp"
 #include "par_rmq_n.hpp"
-#include "string_sort_helper.hpp"
+#include "rk_prime.hpp"
 
-#ifdef DETAILED_TIME
-#include <malloc_count.h>
-#endif
+#include "../util/numa.hpp"
+#include "../util/phase_profiler.hpp"
 
 namespace lce_test::par {
 
+/* How the 3*tau long strings at the string synchronizing set positions are
+ * ranked:
+ * string_sort:  sort all strings (cached_prefix_sorter)
+ * fingerprints: group equal strings by their Karp-Rabin fingerprint and sort
+ *               one string per group (Monte Carlo: a fingerprint collision
+ *               merges two groups) */
+enum class sss_ranking { string_sort, fingerprints };
+
+/* Fingerprint and run information of the string at position index of the
+   string synchronizing set. */
 template <typename sss_type>
-struct rank_tuple {
+struct fingerprint_tuple {
+  __extension__ typedef unsigned __int128 uint128_t;
+  uint128_t fingerprint;
+  int64_t run_info;
   sss_type index;
-  uint32_t rank; //We assume the string synchronizing set hold less than 2^31 values. For tau=512 this is around 500GB text.
-
-  rank_tuple() = default;
-  rank_tuple(sss_type _index, uint32_t _rank) : index(_index), rank(_rank) {}
-
-  friend std::ostream& operator<<(std::ostream& os, rank_tuple const& rt) {
-    return os << "[ " << rt.index << ", " << rt.rank << "]";
-  }
-};  // struct rank_tuple
+};
 
-template <typename sss_type, uint64_t kTau = 1024>
+/* LCE data structure on the string synchronizing set positions. The text is
+ * accessed through text_iterator, which is a pointer to the text or, for
+ * backward LCE queries, a reverse iterator over the same bytes. isa_type is
+ * the width of the inverse suffix array and of the RMQ positions; it must hold
+ * the number of string synchronizing set positions (the constructor throws
+ * std::length_error otherwise), i.e., uint64_t is only needed for more than
+ * 2^32 - 1 positions. */
+template <typename sss_type, uint64_t kTau = 1024, typename text_iterator = uint8_t const*,
+          typename isa_type = uint32_t>
 class Lce_rmq_par {
  public:
-  Lce_rmq_par(uint8_t const* const v_text, size_t const v_text_size,
-              string_synchronizing_set_par<kTau, sss_type> const& sync_set)
+  Lce_rmq_par(text_iterator const v_text, size_t const v_text_size,
+              string_synchronizing_set_par<kTau, sss_type> const& sync_set,
+              lce_test::phase_profiler& profiler,
+              sss_ranking const ranking = sss_ranking::string_sort)
       : text(v_text), text_size(v_text_size) {
-#ifdef DETAILED_TIME
-    size_t mem_before = malloc_count_current();
-    malloc_count_reset_peak();
-    std::chrono::system_clock::time_point begin = std::chrono::system_clock::now();
-#endif
-
-    // Sort 3*tau long strings starting at string synchronizing set positions in parallel
-    std::vector<sss_type> strings_to_sort(sync_set.get_sss().begin(), sync_set.get_sss().end());
-    mock_string text_str(v_text, v_text_size);
-    StringShortSuffixSet<3 * kTau, sss_type> sufset{text_str, strings_to_sort.begin(), strings_to_sort.end(), sync_set};
-
-    tlx::sort_strings_detail::StringPtr strptr(sufset);
-    tlx::sort_strings_detail::parallel_sample_sort(strptr, 0, static_cast<size_t>(omp_get_max_threads()), 0);
-    
-    // Check sorted strings
-    /*{
-      for (size_t idx = 1; idx < strings_to_sort.size(); ++idx) {
-        size_t i = strings_to_sort[idx - 1];
-        size_t j = strings_to_sort[idx];
-        assert(leq_three_tau(i, j, sync_set));
-      }
-    }*/
-
-#ifdef DETAILED_TIME
-    std::chrono::system_clock::time_point end = std::chrono::system_clock::now();
-    std::cout << "string_sort_time="
-              << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << " "
-              << "string_sort_mem=" << (malloc_count_peak() - mem_before) << " ";
-#endif
-
-#ifdef DETAILED_TIME
-    mem_before = malloc_count_current();
-    malloc_count_reset_peak();
-    begin = std::chrono::system_clock::now();
-#endif
-
-    // Reduce alphabet by giving sorted strings their rank.
-    std::vector<rank_tuple<sss_type>> rank_tuples(strings_to_sort.size()); // Store <sss_index, rank> tuples.
-    // We may need to adjust ranks at thread borders.
-    int nt = omp_get_max_threads();
-    std::vector<sss_type> max_ranks(nt);  // Max rank in block
-    std::vector<char> all_ranks_equal(nt); // Are all ranks in the block equal?
-    std::vector<char> rank_extends_prev_block(nt); // Is first rank in block == last rank in prev block?
+    // The reduced text has one character per string synchronizing set position and a sentinel.
+    // It is suffix sorted with 32-bit libsais if possible and with 64-bit libsais otherwise.
+    uint64_t const reduced_size = sync_set.size() + 1;
+    if (reduced_size - 1 > uint64_t{std::numeric_limits<isa_type>::max()}) {
+      throw std::length_error("Lce_rmq_par: too many string synchronizing set positions for isa_type");
+    }
+    if (reduced_size < uint64_t{std::numeric_limits<int32_t>::max()}) {
+      construct<uint32_t>(sync_set, profiler, ranking);
+    } else {
+      construct<uint64_t>(sync_set, profiler, ranking);
+    }
 
-#pragma omp parallel
-    {
-      // First compare strings in block and adjust ranks
-      const int t = omp_get_thread_num();
-      const int nt = omp_get_num_threads();
-      const size_t size_per_thread = rank_tuples.size() / nt;
-      const size_t start_i = t * size_per_thread;
-      const size_t end_i = (t == nt - 1) ? rank_tuples.size() : (t + 1) * size_per_thread;
+    profiler.start("rmq_construct");
+    // Build RMQ data structure
+    rmq_ds1 = std::make_unique<par_RMQ_n<sss_type, isa_type>>(lcp);
+    profiler.stop();
+  }
 
-      uint32_t cur_rank = start_i + 1;
-      rank_tuples[start_i] = {static_cast<sss_type>(strings_to_sort[start_i]), cur_rank};
+  /* Copy of the query arrays (isa, lcp and RMQ) bound to the given NUMA node */
+  Lce_rmq_par(Lce_rmq_par const& other, int const node)
+      : text(other.text),
+        text_size(other.text_size),
+        isa(lce_test::numa_copy(other.isa, node)),
+        lcp(lce_test::numa_copy(other.lcp, node)),
+        rmq_ds1(std::make_unique<par_RMQ_n<sss_type, isa_type>>(*other.rmq_ds1, lcp, node)) {}
 
-      for (size_t i = start_i + 1; i < end_i; ++i) {
-        assert(leq_three_tau(strings_to_sort[i-1], strings_to_sort[i], sync_set));
-        if(!eq_three_tau(strings_to_sort[i-1], strings_to_sort[i], sync_set)) {
-          ++cur_rank;
-        }
-        rank_tuples[i] = {strings_to_sort[i], cur_rank};
-      }
-      max_ranks[t] = cur_rank;
+  uint64_t lce(uint64_t i, uint64_t j) const {
+    if (i == j) {
+      return text_size - i;
+    }
 
-#pragma omp barrier
-      assert (rank_tuples[start_i].rank == start_i+1);
-      all_ranks_equal[t] = (max_ranks[t] == start_i+1);
-      rank_extends_prev_block[t] = (t == 0) ? false : eq_three_tau(strings_to_sort[start_i-1], strings_to_sort[start_i], sync_set);
-#pragma omp barrier
-      // Now adjust ranks between blocks 
-      if(t != 0) {
-        if(rank_extends_prev_block[t]) {
-          size_t target_t = t-1;
-          while(all_ranks_equal[target_t] && rank_extends_prev_block[target_t]) {
-            --target_t;
-          }
-          sss_type target_rank = max_ranks[target_t];
-          
-          const uint32_t rank_to_decrease = rank_tuples[start_i].rank;
-          for (size_t i = start_i; i < end_i && rank_tuples[i].rank == rank_to_decrease; ++i) { 
-            rank_tuples[i].rank = target_rank;
-          }
-        } 
-      }
+    auto min = std::min(isa[i], isa[j]) + 1;
+    auto max = std::max(isa[i], isa[j]);
+    if (max - min > 1024) {  // THIS 1024 HAS NOTHING TO DO WITH KTAU; DONT CHANGE IT
+      return lcp[rmq_ds1->rmq(min, max)];
     }
-    uint32_t max_rank = rank_tuples.back().rank + 1;
-    // Check rank_tuples
-    /*{
-      assert(rank_tuples.size() == strings_to_sort.size());
-      for(size_t i = 0; i < rank_tuples.size(); ++i) {
-        assert(rank_tuples[i].index == strings_to_sort[i]);
-      }
+    auto result = lcp[min];
+    for (auto i = min + 1; i <= max; ++i) {
+      result = std::min(result, lcp[i]);
+    }
+    return result;
+  }
 
-      for(size_t i = 1; i < rank_tuples.size(); ++i) {
-        bool neq_neighbors = (rank_tuples[i-1].rank) < (rank_tuples[i].rank);
-        assert(neq_neighbors == !eq_three_tau(rank_tuples[i-1].index, rank_tuples[i].index, sync_set));
-      }
-    }*/
+  uint64_t get_size() {
+    return text_size;
+  }
+
+  lce_test::memory_report memory_breakdown() const {
+    lce_test::memory_report report;
+    report.add("isa", lce_test::bytes_of(isa));
+    report.add("lcp", lce_test::bytes_of(lcp));
+    report.add("rmq", rmq_ds1->memory_breakdown());
+    return report;
+  }
 
-    ips4o::sort(rank_tuples.begin(), rank_tuples.end(),
-                [](rank_tuple<sss_type> const& lhs, rank_tuple<sss_type> const& rhs) {
-                  return lhs.index < rhs.index;
-                });
+ private:
+  text_iterator const text;
+  size_t text_size;
 
-    std::vector<uint32_t> new_text(rank_tuples.size() + 1, 0);
-    std::vector<uint32_t> new_sa(new_text.size(), 0);
-#pragma omp parallel for
-    for (size_t i = 0; i < rank_tuples.size(); ++i) {
-      new_text[i] = rank_tuples[i].rank;
-    }
+  lce_test::numa_vector<isa_type> isa;
+  lce_test::numa_vector<sss_type> lcp;
+  std::unique_ptr<par_RMQ_n<sss_type, isa_type>> rmq_ds1;
+
+  /* Ranks the strings, suffix sorts the reduced text (with libsais on 32-bit
+     or 64-bit integers, depending on rank_type) and computes the inverse
+     suffix array and the LCP array. */
+  template <typename rank_type>
+  void construct(string_synchronizing_set_par<kTau, sss_type> const& sync_set,
+                 lce_test::phase_profiler& profiler, sss_ranking const ranking) {
+    // Reduce alphabet by giving the 3*tau long strings starting at string synchronizing set positions their rank.
+    lce_test::numa_vector<rank_type> new_text;
+    lce_test::numa_resize(new_text, sync_set.size() + 1);
+    rank_type const max_rank = (ranking == sss_ranking::fingerprints)
+                                   ? rank_by_fingerprints(sync_set, new_text, profiler)
+                                   : rank_by_string_sort(sync_set, new_text, profiler);
     new_text.back() = 0;
-    libsais_int_omp(reinterpret_cast<int32_t*>(new_text.data()), reinterpret_cast<int32_t*>(new_sa.data()), new_text.size(), max_rank + 1, 0, omp_get_max_threads());
-
-#ifdef DETAILED_TIME
-    end = std::chrono::system_clock::now();
-    std::cout << "sa_construct_time="
-              << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << " "
-              << "sa_construct_mem=" << (malloc_count_peak() - mem_before) << " ";
-#endif
-
-#ifdef DETAILED_TIME
-    mem_before = malloc_count_current();
-    malloc_count_reset_peak();
-    begin = std::chrono::system_clock::now();
-#endif
-    isa.resize(new_sa.size());
-#pragma omp parallel for
-    for (uint32_t i = 0; i < new_sa.size(); ++i) {
+    lce_test::numa_vector<rank_type> new_sa;
+    lce_test::numa_resize(new_sa, new_text.size());
+    if constexpr (sizeof(rank_type) == sizeof(int32_t)) {
+      libsais_int_omp(reinterpret_cast<int32_t*>(new_text.data()), reinterpret_cast<int32_t*>(new_sa.data()), new_text.size(), max_rank + 1, 0, omp_get_max_threads());
+    } else {
+      libsais64_long_omp(reinterpret_cast<int64_t*>(new_text.data()), reinterpret_cast<int64_t*>(new_sa.data()), new_text.size(), max_rank + 1, 0, omp_get_max_threads());
+    }
+
+    profiler.start("lcp_construct");
+    lce_test::numa_resize(isa, new_sa.size());
+#pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < new_sa.size(); ++i) {
       isa[new_sa[i]] = i;
     }
 
-    lcp.resize(new_sa.size());
+    lce_test::numa_resize(lcp, new_sa.size());
     lcp[0] = 0;
     lcp[1] = 0;
     size_t current_lcp = 0;
-#pragma omp parallel for firstprivate (current_lcp)
+#pragma omp parallel for schedule(static) firstprivate (current_lcp)
     for (size_t i = 0; i < lcp.size()-1; ++i) {
       size_t suffix_array_pos = isa[i];
       assert(suffix_array_pos != 0); //We stop loop before before isa[lce.size()-1]==0
@@ -192,6 +168,9 @@ class Lce_rmq_par {
       current_lcp += lce_in_text(sync_set[i] + current_lcp, sync_set[preceding_suffix_pos] + current_lcp);
       lcp[suffix_array_pos] = current_lcp;
 
+      if (i + 1 == sync_set.size()) {
+        continue;  // Last suffix, there is no next position
+      }
       uint64_t diff = sync_set[i + 1] - sync_set[i];
       if (current_lcp < 2 * kTau + diff) {
         current_lcp = 0;
@@ -213,59 +192,168 @@ class Lce_rmq_par {
         assert(lce == lcp[i]);
       }
     }*/
-    
-
-#ifdef DETAILED_TIME
-    end = std::chrono::system_clock::now();
-    std::cout << "lcp_construct_time="
-              << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << " "
-              << "lcp_construct_mem=" << (malloc_count_peak() - mem_before) << " ";
-#endif
-
-#ifdef DETAILED_TIME
-    mem_before = malloc_count_current();
-    malloc_count_reset_peak();
-    begin = std::chrono::system_clock::now();
-#endif
-    // Build RMQ data structure
-    rmq_ds1 = std::make_unique<par_RMQ_n<sss_type>>(lcp);
-
-#ifdef DETAILED_TIME
-    end = std::chrono::system_clock::now();
-    std::cout << "rmq_construct_time="
-              << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << " "
-              << "rmq_construct_mem=" << (malloc_count_peak() - mem_before) << " ";
-#endif
   }
 
-  uint64_t lce(uint64_t i, uint64_t j) const {
-    if (i == j) {
-      return text_size - i;
-    }
+  /* Ranks the strings by sorting them. Equal strings get the same rank. */
+  template <typename rank_type>
+  rank_type rank_by_string_sort(string_synchronizing_set_par<kTau, sss_type> const& sync_set,
+                                lce_test::numa_vector<rank_type>& new_text,
+                                lce_test::phase_profiler& profiler) {
+    profiler.start("string_sort");
 
-    auto min = std::min(isa[i], isa[j]) + 1;
-    auto max = std::max(isa[i], isa[j]);
-    if (max - min > 1024) {  // THIS 1024 HAS NOTHING TO DO WITH KTAU; DONT CHANGE IT
-      return lcp[rmq_ds1->rmq(min, max)];
+    // Sort 3*tau long strings starting at string synchronizing set positions in parallel
+    std::vector<sss_type> strings_to_sort(sync_set.size());
+#pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < strings_to_sort.size(); ++i) {
+      strings_to_sort[i] = i;
     }
-    auto result = lcp[min];
-    for (auto i = min + 1; i <= max; ++i) {
-      result = std::min(result, lcp[i]);
+    std::vector<uint8_t> differs;
+    cached_prefix_sorter<kTau, sss_type, text_iterator>(text, text_size, sync_set).sort(strings_to_sort, differs);
+
+    profiler.start("sa_construct");
+
+    // Reduce alphabet by giving sorted strings their rank, i.e., the number of
+    // strings up to them that differ from their predecessor (as reported by
+    // the sorter, prefix sum), and write the ranks to the string synchronizing
+    // set indices.
+    std::vector<rank_type> block_offset(omp_get_max_threads() + 1, 0);
+#pragma omp parallel
+    {
+      const int t = omp_get_thread_num();
+      const int nt = omp_get_num_threads();
+      const size_t size_per_thread = strings_to_sort.size() / nt;
+      const size_t start_i = t * size_per_thread;
+      const size_t end_i = (t == nt - 1) ? strings_to_sort.size() : (t + 1) * size_per_thread;
+
+      rank_type block_differs = 0;
+      for (size_t i = start_i; i < end_i; ++i) {
+        block_differs += differs[i];
+      }
+      block_offset[t + 1] = block_differs;
+#pragma omp barrier
+#pragma omp single
+      for (size_t b = 1; b < block_offset.size(); ++b) {
+        block_offset[b] += block_offset[b - 1];
+      }
+      rank_type cur_rank = block_offset[t];
+      for (size_t i = start_i; i < end_i; ++i) {
+        cur_rank += differs[i];
+        new_text[strings_to_sort[i]] = cur_rank;
+      }
     }
-    return result;
+    return block_offset.back() + 1;
   }
 
-  uint64_t get_size() {
-    return text_size;
-  }
+  /* Ranks the strings by grouping equal strings with their fingerprints.
+     Only one string per group is sorted, i.e., equal strings are never
+     compared character by character. Strings that are cut off by the end of
+     the text are not fingerprinted and form a group each. */
+  template <typename rank_type>
+  rank_type rank_by_fingerprints(string_synchronizing_set_par<kTau, sss_type> const& sync_set,
+                                 lce_test::numa_vector<rank_type>& new_text,
+                                 lce_test::phase_profiler& profiler) {
+    __extension__ typedef unsigned __int128 uint128_t;
+    constexpr size_t prime_exp = 107;
+    constexpr uint64_t string_length = 3 * kTau;
+    // Larger than all fingerprints (which are smaller than 2^prime_exp - 1)
+    constexpr uint128_t no_fingerprint = uint128_t{1} << prime_exp;
+
+    profiler.start("fingerprint");
+    size_t const num_strings = sync_set.size();
+    std::vector<fingerprint_tuple<sss_type>> fingerprints(num_strings);
+    // All threads need the same base; base * prime must fit into 127 bits.
+    std::mt19937_64 random_engine(std::random_device{}());
+    uint64_t const base = std::uniform_int_distribution<uint64_t>(2, (uint64_t{1} << 19) - 1)(random_engine);
+#pragma omp parallel
+    {
+      const int t = omp_get_thread_num();
+      const int nt = omp_get_num_threads();
+      const size_t size_per_thread = num_strings / nt + 1;
+      const size_t start_i = std::min(num_strings, t * size_per_thread);
+      const size_t end_i = std::min(num_strings, (t + 1) * size_per_thread);
+
+      // The window is rolled from string to string
+      size_t full_end_i = start_i;
+      while (full_end_i < end_i && sync_set[full_end_i] + string_length <= text_size) {
+        ++full_end_i;
+      }
+      if (start_i < full_end_i) {
+        herlez::rolling_hash::rk_prime<text_iterator, prime_exp> rk(text + sync_set[start_i], string_length, base);
+        uint64_t window = sync_set[start_i];
+        for (size_t i = start_i; i < full_end_i; ++i) {
+          for (; window < sync_set[i]; ++window) {
+            rk.roll();
+          }
+          fingerprints[i] = {rk.get_current_fp(), sync_set.get_run_info(sync_set[i]), static_cast<sss_type>(i)};
+        }
+      }
+      for (size_t i = full_end_i; i < end_i; ++i) {
+        fingerprints[i] = {no_fingerprint + i, 0, static_cast<sss_type>(i)};
+      }
+    }
+    auto const equal_string = [](fingerprint_tuple<sss_type> const& lhs, fingerprint_tuple<sss_type> const& rhs) {
+      return lhs.fingerprint == rhs.fingerprint && lhs.run_info == rhs.run_info;
+    };
+    ips4o::parallel::sort(fingerprints.begin(), fingerprints.end(),
+                          [](fingerprint_tuple<sss_type> const& lhs, fingerprint_tuple<sss_type> const& rhs) {
+                            return lhs.fingerprint < rhs.fingerprint ||
+                                   (lhs.fingerprint == rhs.fingerprint && lhs.run_info < rhs.run_info);
+                          });
+
+    // One representative (the first string) per group. new_text temporarily
+    // stores the group of each string. Each thread counts the groups starting
+    // in its range, and the prefix sum over the counts gives the number of
+    // its first group.
+    std::vector<sss_type> representatives;
+    std::vector<size_t> block_offset(omp_get_max_threads() + 1, 0);
+#pragma omp parallel
+    {
+      const int t = omp_get_thread_num();
+      const int nt = omp_get_num_threads();
+      const size_t size_per_thread = num_strings / nt;
+      const size_t start_i = t * size_per_thread;
+      const size_t end_i = (t == nt - 1) ? num_strings : (t + 1) * size_per_thread;
+      auto const starts_group = [&](size_t const i) {
+        return i == 0 || !equal_string(fingerprints[i - 1], fingerprints[i]);
+      };
+
+      size_t block_groups = 0;
+      for (size_t i = start_i; i < end_i; ++i) {
+        block_groups += starts_group(i);
+      }
+      block_offset[t + 1] = block_groups;
+#pragma omp barrier
+#pragma omp single
+      {
+        for (size_t b = 1; b < block_offset.size(); ++b) {
+          block_offset[b] += block_offset[b - 1];
+        }
+        representatives.resize(block_offset.back());
+      }
+      size_t group = block_offset[t];
+      for (size_t i = start_i; i < end_i; ++i) {
+        if (starts_group(i)) {
+          representatives[group++] = fingerprints[i].index;
+        }
+        new_text[fingerprints[i].index] = group - 1;
+      }
+    }
 
- private:
-  uint8_t const* const text;
-  size_t text_size;
+    profiler.start("string_sort");
+    cached_prefix_sorter<kTau, sss_type, text_iterator>(text, text_size, sync_set).sort(representatives);
 
-  std::vector<uint32_t> isa;
-  std::vector<sss_type> lcp;
-  std::unique_ptr<par_RMQ_n<sss_type>> rmq_ds1;
+    profiler.start("sa_construct");
+    std::vector<rank_type> group_rank(representatives.size());
+#pragma omp parallel for schedule(static)
+    for (size_t r = 0; r < representatives.size(); ++r) {
+      group_rank[new_text[representatives[r]]] = r + 1;
+    }
+#pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < num_strings; ++i) {
+      new_text[i] = group_rank[new_text[i]];
+    }
+    return group_rank.size() + 1;
+  }
 
   uint64_t lce_in_text(uint64_t i, uint64_t j, uint64_t up_to = std::numeric_limits<uint64_t>::max()) {
     uint64_t const max_length = std::min({text_size - i, text_size - j, up_to});
@@ -5,6 +5,9 @@
 
 #include <vector>
 
+#include "../util/memory_report.hpp"
+#include "../util/numa.hpp"
+
 namespace lce_test::par {
 inline size_t log2_of_uint32(uint32_t const x) {
   assert(x != 0);
@@ -14,28 +17,33 @@ inline size_t log2_of_uint32(uint32_t const x) {
 template <typename key_type>
 class par_RMQ_nlgn {
   key_type const* m_data = nullptr;
-  std::vector<std::vector<uint32_t>> m_power_rmq;
+  std::vector<lce_test::numa_vector<uint32_t>> m_power_rmq;
 
  public:
   par_RMQ_nlgn() {}
 
-  par_RMQ_nlgn(std::vector<key_type> const& data) : m_data(data.data()) {
+  template <typename vector_type>
+  par_RMQ_nlgn(vector_type const& data) : m_data(data.data()) {
+    // A single element needs no levels (rmq compares up to two elements)
+    if (data.size() < 2) {
+      return;
+    }
     const uint32_t m_num_levels = log2_of_uint32(data.size());
     m_power_rmq.resize(m_num_levels);
 
     //Build first level
-    m_power_rmq[0].resize(data.size() - 1);
+    lce_test::numa_resize(m_power_rmq[0], data.size() - 1);
 
-    #pragma omp parallel for
+    #pragma omp parallel for schedule(static)
     for (size_t i = 0; i < data.size() - 1; ++i) {
       m_power_rmq[0][i] = m_data[i] < data[i + 1] ? i : (i + 1);
     }
 
     //Build the rest
     for (size_t l = 1; l < m_num_levels; ++l) {
-      m_power_rmq[l].resize(data.size() - ((uint64_t{2} << l) - 1));
+      lce_test::numa_resize(m_power_rmq[l], data.size() - ((uint64_t{2} << l) - 1));
       uint32_t const span = (uint64_t{1} << l);
-      #pragma omp parallel for
+      #pragma omp parallel for schedule(static)
       for (size_t i = 0; i < m_power_rmq[l].size(); ++i) {
         const uint32_t l_interval_min = m_power_rmq[l - 1][i];
         const uint32_t r_interval_min = m_power_rmq[l - 1][i + span];
@@ -44,6 +52,23 @@ class par_RMQ_nlgn {
     }
   }
 
+  // Copy of other for a copy of its data, bound to the given NUMA node
+  par_RMQ_nlgn(par_RMQ_nlgn const& other, key_type const* data, int const node)
+      : m_data(data) {
+    m_power_rmq.reserve(other.m_power_rmq.size());
+    for (auto const& level : other.m_power_rmq) {
+      m_power_rmq.push_back(lce_test::numa_copy(level, node));
+    }
+  }
+
+  uint64_t size_in_bytes() const {
+    uint64_t bytes = lce_test::bytes_of(m_power_rmq);
+    for (auto const& level : m_power_rmq) {
+      bytes += lce_test::bytes_of(level);
+    }
+    return bytes;
+  }
+
   size_t rmq(size_t const left, size_t const right) const {
     const uint32_t dist = std::max(left, right) - std::min(left, right);
     if (dist <= 1) {
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <omp.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "../util/memory_report.hpp"
+#include "../util/numa.hpp"
+
+namespace lce_test::par {
+
+/* Karp-Rabin fingerprints of the text sampled at the positions of a string
+ * synchronizing set, which decide whether the texts between two pairs of
+ * synchronizing positions are equal (correct with high probability).
+ *
+ * For each position s, we store G(s) = sum_{x < s} T[x] * B^x and B^s modulo
+ * the Mersenne prime 2^61 - 1, with a random base B. Since
+ * G(a + l) - G(a) = B^a * h(T[a, a + l)), two substrings of the same length
+ * are compared by multiplying each difference with the power of the other's
+ * start, i.e., without computing B^l. */
+template <typename sss_type>
+class sss_fingerprints {
+  __extension__ typedef unsigned __int128 uint128_t;
+  static constexpr uint64_t kPrime = (uint64_t{1} << 61) - 1;
+
+ public:
+  sss_fingerprints(uint8_t const* const text, size_t const text_size,
+                   lce_test::numa_vector<sss_type> const& sync_set) {
+    std::mt19937_64 random_engine(std::random_device{}());
+    m_base = std::uniform_int_distribution<uint64_t>(256, kPrime - 1)(random_engine);
+    lce_test::numa_resize(m_prefix, sync_set.size());
+    lce_test::numa_resize(m_power, sync_set.size());
+
+    // Each thread sums up the text in front of its part of the set, starting
+    // at 0. The sums are then shifted by the sums of all previous parts.
+    std::vector<uint64_t> part_sum(omp_get_max_threads() + 1, 0);
+#pragma omp parallel
+    {
+      const int t = omp_get_thread_num();
+      const int nt = omp_get_num_threads();
+      const size_t size_per_thread = sync_set.size() / nt + 1;
+      const size_t start_i = std::min(sync_set.size(), t * size_per_thread);
+      const size_t end_i = std::min(sync_set.size(), (t + 1) * size_per_thread);
+
+      uint64_t pos = (t == 0 || start_i == end_i) ? 0 : sync_set[start_i];
+      uint64_t const end_pos = (end_i < sync_set.size()) ? sync_set[end_i] : pos;
+      uint64_t power = pow(m_base, pos);
+      uint64_t sum = 0;
+      for (size_t i = start_i; i < end_i; ++i) {
+        for (; pos < sync_set[i]; ++pos) {
+          sum = add(sum, mul(text[pos], power));
+          power = mul(power, m_base);
+        }
+        m_prefix[i] = sum;
+        m_power[i] = power;
+      }
+      for (; pos < end_pos && pos < text_size; ++pos) {
+        sum = add(sum, mul(text[pos], power));
+        power = mul(power, m_base);
+      }
+      part_sum[t + 1] = sum;
+#pragma omp barrier
+#pragma omp single
+      for (size_t p = 1; p < part_sum.size(); ++p) {
+        part_sum[p] = add(part_sum[p], part_sum[p - 1]);
+      }
+      for (size_t i = start_i; i < end_i; ++i) {
+        m_prefix[i] = add(m_prefix[i], part_sum[t]);
+      }
+    }
+  }
+
+  /* Whether T[s[a], s[a + k]) = T[s[b], s[b + k]), where s is the string
+     synchronizing set. Both substrings must have the same length. */
+  inline bool equal(size_t const a, size_t const b, size_t const k) const {
+    uint64_t const fp_a = sub(m_prefix[a + k], m_prefix[a]);
+    uint64_t const fp_b = sub(m_prefix[b + k], m_prefix[b]);
+    return mul(fp_a, m_power[b]) == mul(fp_b, m_power[a]);
+  }
+
+  lce_test::memory_report memory_breakdown() const {
+    lce_test::memory_report report;
+    report.add("prefix", lce_test::bytes_of(m_prefix));
+    report.add("power", lce_test::bytes_of(m_power));
+    return report;
+  }
+
+ private:
+  uint64_t m_base;
+  lce_test::numa_vector<uint64_t> m_prefix;  // G(s[i])
+  lce_test::numa_vector<uint64_t> m_power;   // B^s[i]
+
+  static inline uint64_t mul(uint64_t const a, uint64_t const b) {
+    uint128_t const product = uint128_t{a} * b;
+    uint64_t r = (static_cast<uint64_t>(product) & kPrime) + static_cast<uint64_t>(product >> 61);
+    r = (r & kPrime) + (r >> 61);
+    return r >= kPrime ? r - kPrime : r;
+  }
+
+  static inline uint64_t add(uint64_t const a, uint64_t const b) {
+    uint64_t const r = a + b;
+    return r >= kPrime ? r - kPrime : r;
+  }
+
+  static inline uint64_t sub(uint64_t const a, uint64_t const b) {
+    return a >= b ? a - b : a + kPrime - b;
+  }
+
+  static uint64_t pow(uint64_t base, uint64_t exp) {
+    uint64_t result = 1;
+    while (exp > 0) {
+      if (exp & 1) {
+        result = mul(result, base);
+      }
+      base = mul(base, base);
+      exp >>= 1;
+    }
+    return result;
+  }
+};
+
+}  // namespace lce_test::par
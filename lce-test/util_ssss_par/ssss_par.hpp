@@ -2,55 +2,124 @@
 
 #include <omp.h>
 
+#include <algorithm>
+#include <atomic>
+#include <span>
 #include <string>
 #include <vector>
-#include <parallel_hashmap/phmap.h>
-#include <mutex>
 
 #include "../util/synchronizing_sets/ring_buffer.hpp"
 #include "rk_prime.hpp"
+#include "../util/memory_report.hpp"
+#include "../util/numa.hpp"
+
+/* Periodic region T[start, end] with period period, which is found while
+ * computing a string synchronizing set with runs. If the run is at least
+ * 3 * tau - 1 long and does not start at 0, run_info orders the suffix at
+ * the synchronizing position start - 1 among those with the same 3 * tau
+ * long prefix. Otherwise, run_info is 0. */
+template <typename t_index>
+struct sss_run {
+  t_index start;
+  t_index end;
+  t_index period;
+  int64_t run_info;
+};
 
 template <size_t t_tau = 1024, typename t_index = uint32_t>
 class string_synchronizing_set_par {
   __extension__ typedef unsigned __int128 uint128_t;
 
+ public:
+  using run_type = sss_run<t_index>;
+
  private:
-  std::vector<t_index> m_sss;
+  lce_test::numa_vector<t_index> m_sss;
   bool m_runs_detected;
-  phmap::parallel_flat_hash_map<t_index, int64_t, phmap::priv::hash_default_hash<t_index>,
-      phmap::priv::hash_default_eq<t_index>, 
-      phmap::priv::Allocator<std::pair<const t_index, int64_t>>,
-      4, std::mutex> m_run_info;
+  std::vector<run_type> m_runs;  // Sorted by start
 
  public:
   static const size_t tau = t_tau;
-  std::vector<t_index> const& get_sss() const {
+  lce_test::numa_vector<t_index> const& get_sss() const {
     return m_sss;
   }
 
   int64_t get_run_info(t_index i) const {
-    auto run_info_entry = m_run_info.find(i);
-    return run_info_entry == m_run_info.end() ? 0 : run_info_entry->second;
+    auto const run = std::lower_bound(m_runs.begin(), m_runs.end(), i + 1,
+                                      [](run_type const& r, t_index const pos) {
+                                        return r.start < pos;
+                                      });
+    return (run != m_runs.end() && run->start == i + 1) ? run->run_info : 0;
   }
   
   bool has_runs() const {
     return m_runs_detected;
   }
   size_t num_runs() const {
-    return m_run_info.size();
+    return m_runs.size();
   }
   size_t size() const {
     return m_sss.size();
   }
 
+  /* All runs found during the construction (only if has_runs()), sorted by
+     start. Their periods are at most tau / 3 and they are at least tau
+     long. */
+  std::span<run_type const> get_runs() const {
+    return m_runs;
+  }
+
+  /* Runs that start in [from, to) */
+  std::span<run_type const> runs_starting_in(t_index const from, t_index const to) const {
+    auto const by_start = [](run_type const& r, t_index const pos) {
+      return r.start < pos;
+    };
+    auto const first = std::lower_bound(m_runs.begin(), m_runs.end(), from, by_start);
+    auto const last = std::lower_bound(first, m_runs.end(), to, by_start);
+    return {first, last};
+  }
+
+  /* A run containing position i, or nullptr. Two runs overlap by less than
+     the sum of their periods, so no run contains an earlier run completely,
+     and only the last run starting at or before i can contain i. */
+  run_type const* run_containing(t_index const i) const {
+    auto const next = std::upper_bound(m_runs.begin(), m_runs.end(), i,
+                                       [](t_index const pos, run_type const& r) {
+                                         return pos < r.start;
+                                       });
+    if (next == m_runs.begin() || std::prev(next)->end < i) {
+      return nullptr;
+    }
+    return &*std::prev(next);
+  }
+
+  lce_test::memory_report memory_breakdown() const {
+    lce_test::memory_report report;
+    report.add("positions", lce_test::bytes_of(m_sss));
+    report.add("runs", lce_test::bytes_of(m_runs));
+    return report;
+  }
+
   inline t_index operator[](size_t i) const {
     return m_sss[i];
   }
 
   string_synchronizing_set_par() = default;
-  string_synchronizing_set_par(const std::vector<uint8_t>& text) {
+  /* The text is any random access sequence of bytes with size() and cbegin(),
+     e.g., a std::vector<uint8_t> or a lce_test::reversed_text_view. */
+  template <typename text_type>
+  explicit string_synchronizing_set_par(text_type const& text) {
     std::vector<std::vector<t_index>> sss_part(omp_get_max_threads());
+    // Each thread collects the runs starting in its range, which are
+    // concatenated afterwards (no shared state during the construction).
+    std::vector<std::vector<run_type>> run_part(sss_part.size());
 
+    //If the text contains long runs, the sss inflates. We then use an algorithm which detects runs.
+    //The size only grows, so all threads switch as soon as the sizes published so far exceed the bound.
+    //A thread keeps the positions of its plain pass in front of the first run of its part, so only
+    //the plain positions from there on are computed twice (see fill_synchronizing_set_runs).
+    const size_t max_sss_size = text.size() * 6 / t_tau;
+    std::atomic<size_t> sss_size_so_far{0};
 #pragma omp parallel
     {
       const size_t sss_end = text.size() - 2 * t_tau + 1;
@@ -58,36 +127,31 @@ class string_synchronizing_set_par {
       const int t = omp_get_thread_num();
       const size_t start = size_per_thread * t;
       const size_t end = (t == omp_get_num_threads() - 1) ? sss_end : (t + 1) * size_per_thread;
-      sss_part[t] = fill_synchronizing_set(text, start, end);
+      const size_t plain_end = fill_synchronizing_set(text, start, end, sss_part[t], sss_size_so_far, max_sss_size);
+#pragma omp barrier
+      if (sss_size_so_far.load() > max_sss_size) {
+        fill_synchronizing_set_runs(text, start, end, sss_part[t], plain_end, run_part[t]);
+      }
     }
+    m_runs_detected = sss_size_so_far.load() > max_sss_size;
 
     //Merge SSS parts
     std::vector<size_t> write_pos{0};
     for (auto& part : sss_part) {
       write_pos.push_back(write_pos.back() + part.size());
     }
-    size_t sss_size = write_pos.back();  //+1 for sentinel
-    m_runs_detected = sss_size > text.size()*6 / t_tau;
-
-    //If the text contains long runs, the sss inflates. We the then use a algorithm which detects runs.
+    size_t sss_size = write_pos.back();
     if (m_runs_detected) {
-#pragma omp parallel
-      {
-        const size_t sss_end = text.size() - 2 * t_tau + 1;
-        const size_t size_per_thread = (sss_end / omp_get_num_threads()) + 1;
-        const int t = omp_get_thread_num();
-        const size_t start = size_per_thread * t;
-        const size_t end = (t == omp_get_num_threads() - 1) ? sss_end : (t + 1) * size_per_thread;
-        sss_part[t] = fill_synchronizing_set_runs(text, start, end);
+      sss_size += 1;  //+1 for sentinel
+      for (auto& part : run_part) {
+        m_runs.insert(m_runs.end(), part.begin(), part.end());
       }
-      write_pos = {0};
-      for (auto& part : sss_part) {
-        write_pos.push_back(write_pos.back() + part.size());
-      }
-      sss_size = write_pos.back() + 1;  //+1 for sentinel
+      std::sort(m_runs.begin(), m_runs.end(), [](run_type const& a, run_type const& b) {
+        return a.start < b.start;
+      });
     }
 
-    m_sss.resize(sss_size);
+    lce_test::numa_resize(m_sss, sss_size);
 #pragma omp parallel
     {
       const int t = omp_get_thread_num();
@@ -98,16 +162,71 @@ class string_synchronizing_set_par {
     }
   }
 
-  std::vector<t_index> fill_synchronizing_set(const std::vector<uint8_t>& text, const size_t from, const size_t to) const {
-    //calculate SSS
-    std::vector<t_index> sss;
+  /* String synchronizing set of text, whose first prefix_size characters are
+     the text of the set prefix. Whether i is in the set only depends on
+     T[i, i + 2 * tau), so the positions of prefix are kept and only the
+     positions of the tail are computed. If prefix is shorter than
+     2 * tau - 1 characters (i.e., has no positions), has runs (whose order
+     information depends on the end of the text) or the tail makes the set
+     too large, the set is computed from scratch. */
+  template <typename text_type>
+  string_synchronizing_set_par(text_type const& text, string_synchronizing_set_par const& prefix,
+                               size_t const prefix_size) {
+    const size_t max_sss_size = text.size() * 6 / t_tau;
+    if (prefix_size < 2 * t_tau - 1 || prefix.has_runs() || prefix.size() > max_sss_size) {
+      *this = string_synchronizing_set_par(text);
+      return;
+    }
+    const size_t tail_begin = prefix_size - 2 * t_tau + 1;
+    const size_t sss_end = text.size() - 2 * t_tau + 1;
+
+    std::vector<std::vector<t_index>> sss_part(omp_get_max_threads());
+    std::atomic<size_t> sss_size_so_far{prefix.size()};
+#pragma omp parallel
+    {
+      const size_t size_per_thread = ((sss_end - tail_begin) / omp_get_num_threads()) + 1;
+      const int t = omp_get_thread_num();
+      const size_t start = std::min(sss_end, tail_begin + size_per_thread * t);
+      const size_t end = (t == omp_get_num_threads() - 1) ? sss_end : std::min(sss_end, start + size_per_thread);
+      fill_synchronizing_set(text, start, end, sss_part[t], sss_size_so_far, max_sss_size);
+    }
+    if (sss_size_so_far.load() > max_sss_size) {
+      *this = string_synchronizing_set_par(text);
+      return;
+    }
+    m_runs_detected = false;
+
+    std::vector<size_t> write_pos{prefix.size()};
+    for (auto& part : sss_part) {
+      write_pos.push_back(write_pos.back() + part.size());
+    }
+    lce_test::numa_resize(m_sss, write_pos.back());
+    std::copy(prefix.get_sss().begin(), prefix.get_sss().end(), m_sss.begin());
+#pragma omp parallel
+    {
+      const int t = omp_get_thread_num();
+      std::copy(sss_part[t].begin(), sss_part[t].end(), m_sss.begin() + write_pos[t]);
+    }
+  }
+
+  /* Stops early once the sizes published to sss_size_so_far by all threads
+     exceed max_sss_size, i.e., once the text is known to contain long runs.
+     Returns the end of the range [from, end) whose positions are in sss. */
+  template <typename text_type>
+  size_t fill_synchronizing_set(text_type const& text, const size_t from, const size_t to, std::vector<t_index>& sss,
+                                std::atomic<size_t>& sss_size_so_far, const size_t max_sss_size) const {
+    constexpr size_t publish_interval = size_t{1} << 12;
+    size_t published = 0;
 
     herlez::rolling_hash::rk_prime<decltype(text.cbegin()), 107> rk(text.cbegin() + from, t_tau, 296813);
     ring_buffer<uint128_t> fingerprints(4 * t_tau);
     fingerprints.resize(from);
     fingerprints.push_back(rk.get_current_fp());
 
-    t_index first_min = 0;
+    // Rightmost minimum of the window [i, i + tau]. Only its fingerprint
+    // matters, and it stays in the window longest, so in a run (where the
+    // minimum repeats) the window is not scanned again at every position.
+    t_index last_min = 0;
 
     //Loop:
     for (size_t i = from; i < to; ++i) {
@@ -115,27 +234,45 @@ class string_synchronizing_set_par {
         fingerprints.push_back(rk.roll());
       }
 
-      if (first_min == 0 || first_min < i) {
-        first_min = i;
+      if (last_min == 0 || last_min < i) {
+        last_min = i;
         for (size_t j = i; j <= i + t_tau; ++j) {
-          if (fingerprints[j] < fingerprints[first_min]) {
-            first_min = j;
+          if (fingerprints[j] <= fingerprints[last_min]) {
+            last_min = j;
           }
         }
-      } else if (fingerprints[i + t_tau] < fingerprints[first_min]) {
-        first_min = i + t_tau;
+      } else if (fingerprints[i + t_tau] <= fingerprints[last_min]) {
+        last_min = i + t_tau;
       }
 
-      if (fingerprints[first_min] == fingerprints[i] || fingerprints[first_min] == fingerprints[i + t_tau]) {
+      if (fingerprints[last_min] == fingerprints[i] || fingerprints[last_min] == fingerprints[i + t_tau]) {
         sss.push_back(i);
       }
+      if ((i - from) % publish_interval == publish_interval - 1) {
+        if (sss_size_so_far.fetch_add(sss.size() - published) + sss.size() - published > max_sss_size) {
+          return i + 1;
+        }
+        published = sss.size();
+      }
     }
-    return sss;
+    sss_size_so_far.fetch_add(sss.size() - published);
+    return to;
   }
 
-  std::vector<t_index> fill_synchronizing_set_runs(const std::vector<uint8_t>& text, const size_t from, const size_t to) {
+  /* Replaces the positions of the plain set in sss, which cover [from,
+     plain_end), by the set with runs for [from, to). Both sets agree on the
+     positions i whose fingerprints [i, i + tau] are outside of periodic
+     regions, so the positions in front of the first periodic region (minus
+     tau) are kept and the fingerprints are only computed from there on. */
+  template <typename text_type>
+  void fill_synchronizing_set_runs(text_type const& text, const size_t from, const size_t to,
+                                   std::vector<t_index>& sss, const size_t plain_end,
+                                   std::vector<run_type>& runs) const {
     //calculate Q
-    std::vector<std::pair<t_index, t_index>> qset = calculate_q(text, from, to);
+    std::vector<std::pair<t_index, t_index>> qset = calculate_q(text, from, to, runs);
+    const size_t first_periodic = qset.empty() ? to + t_tau : qset.front().first;
+    const size_t resume = std::min(plain_end, std::max(from + t_tau, first_periodic) - t_tau);
+    sss.erase(std::lower_bound(sss.begin(), sss.end(), resume), sss.end());
     
     /* PRINT Q
     #pragma omp critical
@@ -153,17 +290,15 @@ class string_synchronizing_set_par {
     auto it_q = qset.begin();
     //calculate SSS
     //BEGIN
-    std::vector<t_index> sss;
-
-    herlez::rolling_hash::rk_prime<decltype(text.cbegin()), 107> rk(text.cbegin() + from, t_tau, 296813);
+    herlez::rolling_hash::rk_prime<decltype(text.cbegin()), 107> rk(text.cbegin() + resume, t_tau, 296813);
     ring_buffer<uint128_t> fingerprints(4 * t_tau);
-    fingerprints.resize(from);
+    fingerprints.resize(resume);
     fingerprints.push_back(rk.get_current_fp());
 
     t_index MIN_UNKNOWN = std::numeric_limits<t_index>::max();
     t_index first_min = MIN_UNKNOWN;
     //Loop:
-    for (size_t i = from; i < to; ++i) {
+    for (size_t i = resume; i < to; ++i) {
       for (size_t j = fingerprints.size(); j <= i + t_tau; ++j) {
         fingerprints.push_back(rk.roll());
       }
@@ -216,10 +351,13 @@ class string_synchronizing_set_par {
         sss.push_back(i);
       }
     }
-    return sss;
   }
 
-  std::vector<std::pair<t_index, t_index>> calculate_q(const std::vector<uint8_t>& text, const size_t from, const size_t to) {
+  /* Calculates the intervals of positions whose tau long substring is
+     periodic. The runs starting in [from, to) are appended to runs. */
+  template <typename text_type>
+  std::vector<std::pair<t_index, t_index>> calculate_q(text_type const& text, const size_t from, const size_t to,
+                                                       std::vector<run_type>& runs) const {
     std::vector<std::pair<t_index, t_index>> qset{};
     constexpr size_t small_tau = t_tau / 3;
     herlez::rolling_hash::rk_prime<decltype(text.cbegin()), 107> rk(text.cbegin() + from, small_tau, 296813);
@@ -270,18 +408,24 @@ class string_synchronizing_set_par {
           qset.push_back(std::make_pair(run_start, run_end - t_tau + 1));
           i = run_end - small_tau;
 
-          if(run_end - run_start + 1 >= 3 * t_tau - 1) {
-            if(run_start==0) { continue; } //Run starts at 0, no run information needed
-            if(text[run_start-1] == text[run_start+period-1]) {continue;} //Run starts at previous PE, we are not responsible
-            while (run_end < text.size() && text[run_end+1] == text[run_end - period+1]) {
-              ++run_end;
-            }
+          if(run_start > 0 && text[run_start-1] == text[run_start+period-1]) {continue;} //Run starts at previous PE, we are not responsible
+          if(run_start >= to) {continue;} //Run starts at next PE
+          while (run_end + 1 < text.size() && text[run_end+1] == text[run_end - period+1]) {
+            ++run_end;
+          }
 
+          int64_t run_info = 0;
+          if(run_start > 0 && run_end - run_start + 1 >= 3 * t_tau - 1) {
             size_t const sss_pos1 = run_start - 1;
             size_t const sss_pos2 = run_end - (2*t_tau) + 2; 
-            int64_t const run_info = int64_t{1} * text.size() - sss_pos2 + sss_pos1;
-            m_run_info[sss_pos1] = text[run_end + 1] > text[run_end - period + 1] ? run_info : run_info * (-1);
+            run_info = int64_t{1} * text.size() - sss_pos2 + sss_pos1;
+            // The end of the text is smaller than any character
+            if(run_end + 1 == text.size() || text[run_end + 1] < text[run_end - period + 1]) {
+              run_info *= -1;
+            }
           }
+          runs.push_back({static_cast<t_index>(run_start), static_cast<t_index>(run_end),
+                          static_cast<t_index>(period), run_info});
         } else {
           i = next_min - 1;
         }
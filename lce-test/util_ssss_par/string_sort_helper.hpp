@@ -3,23 +3,28 @@
 #include "ssss_par.hpp"
 namespace lce_test::par {
 
-struct mock_string {
+/* Text given by an iterator to its first character. The iterator is a plain
+ * pointer or, for the backward LCE, a reverse iterator over the same bytes. */
+template <typename char_iterator = uint8_t const*>
+struct basic_mock_string {
   using size_type = uint64_t;
 
-  mock_string(uint8_t const* const str, size_type size) : m_str(str), m_size(size) {}
+  basic_mock_string(char_iterator const str, size_type size) : m_str(str), m_size(size) {}
 
   size_type size() const {
     return m_size;
   }
-  uint8_t const* data() const {
+  char_iterator data() const {
     return m_str;
   }
 
  private:
-  uint8_t const* const m_str;
+  char_iterator const m_str;
   size_type m_size;
 };
 
+using mock_string = basic_mock_string<>;
+
 template <typename StringSet, typename Traits>
 class StringSetBase {
  public:
@@ -230,11 +235,11 @@ class StringSetBase {
  * Class implementing StringSet concept for suffix sorting indexes of a
  * std::string text object.
  */
-template<typename sss_type = uint32_t>
+template<typename sss_type = uint32_t, typename char_iterator = uint8_t const*>
 class StringShortSuffixSetTraits {
  public:
   //! exported alias for assumed string container
-  typedef mock_string Text;
+  typedef basic_mock_string<char_iterator> Text;
 
   //! exported alias for character type
   typedef uint8_t Char;
@@ -247,32 +252,34 @@ class StringShortSuffixSetTraits {
   typedef typename std::vector<String>::iterator Iterator;
 
   //! iterator of characters in a string
-  typedef const Char* CharIterator;
+  typedef char_iterator CharIterator;
 };
 
 /*!
  * Class implementing StringSet concept for suffix sorting indexes of a
  * std::string text object.
  */
-template <uint64_t t_tau, typename sss_type>
+template <uint64_t t_tau, typename sss_type, typename char_iterator = uint8_t const*>
 class StringShortSuffixSet
-    : public StringShortSuffixSetTraits<sss_type>,
-      public StringSetBase<StringShortSuffixSet<t_tau, sss_type>, StringShortSuffixSetTraits<sss_type>> {
+    : public StringShortSuffixSetTraits<sss_type, char_iterator>,
+      public StringSetBase<StringShortSuffixSet<t_tau, sss_type, char_iterator>,
+                           StringShortSuffixSetTraits<sss_type, char_iterator>> {
+  using traits = StringShortSuffixSetTraits<sss_type, char_iterator>;
 
  public:
   //! exported alias for assumed string container
-  typedef typename StringShortSuffixSetTraits<sss_type>::Text Text;
+  typedef typename traits::Text Text;
   //! exported alias for character type
-  typedef typename StringShortSuffixSetTraits<sss_type>::Char Char;
+  typedef typename traits::Char Char;
   //! String reference: suffix index of the text.
-  typedef typename StringShortSuffixSetTraits<sss_type>::String String;
+  typedef typename traits::String String;
   //! Iterator over string references: using std::vector's iterator over
   //! suffix array vector
-  typedef typename StringShortSuffixSetTraits<sss_type>::Iterator Iterator;
+  typedef typename traits::Iterator Iterator;
   //! exported alias for assumed string container
   typedef std::tuple<Text, std::vector<String>, string_synchronizing_set_par<t_tau/3, sss_type> const&> Container;
   //! iterator of characters in a string
-  typedef typename StringShortSuffixSetTraits<sss_type>::CharIterator CharIterator;
+  typedef typename traits::CharIterator CharIterator;
 
   //! Construct from begin and end string pointers
   StringShortSuffixSet(const Text& text,
@@ -296,7 +303,7 @@ class StringShortSuffixSet
   String& operator[](const Iterator& i) const { return *i; }
 
   //! Return CharIterator for referenced string, which belongs to this set.
-  CharIterator get_chars(const String& s, size_t depth) const { return reinterpret_cast<CharIterator>(text_->data()) + s + depth; }
+  CharIterator get_chars(const String& s, size_t depth) const { return text_->data() + (s + depth); }
 
   //! Returns true if CharIterator is at end of the given String
   bool is_end([[maybe_unused]]const String& str, [[maybe_unused]]const CharIterator& i) const {
@@ -306,7 +313,7 @@ class StringShortSuffixSet
   }
   //! Returns true if CharIterator is at the exact end of the given String
   bool is_exact_end(const String& str, const CharIterator i) const {
-    return i == reinterpret_cast<CharIterator>(std::min(text_->data() + str + t_tau, text_->data() + text_->size()));
+    return i == text_->data() + std::min<uint64_t>(str + t_tau, text_->size());
   } //TODO: i == ... seems wrong; should be i >= ...
 
   //if(ss.has_runs() && ss.is_exact_end(a, ai)) { return ss.is_smaller_run(a, b) };